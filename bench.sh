@@ -0,0 +1,9 @@
+#!/usr/bin/env bash
+
+_DIR=$(cd "$(dirname "$0")"; pwd)
+cd $_DIR
+g++ -O3 $BENCH_CFLAGS -pipe -DNDEBUG -fomit-frame-pointer -Isrc bench/bench.cc \
+  src/rand48.cc src/qdigest.cc src/prng.cc src/lossycount.cc \
+  src/countmin.cc src/gk.cc src/cgt.cc src/ccfc.cc src/frequent.cc src/stats.cc \
+  -o bench/bench || exit 1
+./bench/bench "$@"
@@ -0,0 +1,596 @@
+// bench.cc -- benchmark driver for the frequent items and quantile engines
+//
+// Feeds the same generated streams to every engine and prints one JSON
+// object per line (engine, stream, parameters and measurements), so that
+// runs can be compared with bench/compare.py.
+//
+// Frequent items: Zipf streams from Tools::PRGZipf and fastzipf at several
+// skews, a uniform stream, and an adversarial stream that cycles through
+// just-below-threshold items around one heavy item.  Reported: updates/sec,
+// ns/update percentiles (rdtsc around each update), bytes from *_Size, and
+// recall/precision of the output at threshold phi*n against exact counts.
+//
+// Quantiles: GK and q-digest on latency-like (lognormal and bimodal)
+// values, reporting the largest rank error over a set of quantiles.
+//
+// usage: bench [-n updates] [-s seed] [-e engine,engine,...] [-p phi,phi,...]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <unordered_map>
+#include <x86intrin.h>
+
+#include "prng.h"
+#include "lossycount.h"
+#include "lclsmall.h"
+#include "qdigest.h"
+#include "frequent.h"
+#include "countmin.h"
+#include "ccfc.h"
+#include "cgt.h"
+#include "gk4.h"
+
+#define BENCH_LOGU 20 // items are drawn from [1, 2^BENCH_LOGU)
+#define BENCH_DOMAIN ((1<<BENCH_LOGU)-1)
+#define BENCH_QLOGU 24 // domain of the q-digest in the quantile benchmark
+
+typedef std::map<uint32_t, uint32_t> ItemMap;
+
+/******************************************************************/
+// Engines: each is wrapped in the same small set of functions
+
+typedef struct bench_engine_t {
+	const char * name;
+	void * (*init)(double phi, int seed);
+	void (*update)(void *, uint32_t);
+	ItemMap (*output)(void *, int thresh, const std::vector<uint32_t> & distinct);
+	int (*size)(void *);
+	void (*destroy)(void *);
+	int maxk; // the most counters it can have, or 0 if 1/phi always fits
+} BenchEngine;
+
+static ItemMap SketchOutput(const std::vector<uint32_t> & distinct, int thresh,
+							int (*est)(void *, uint32_t), void * s)
+{
+	// sketches have no list of candidates: query every distinct item
+	ItemMap res;
+	int e;
+	for (size_t i=0;i<distinct.size();i++)
+	{
+		e=est(s,distinct[i]);
+		if (e>=thresh) res[distinct[i]]=e;
+	}
+	return res;
+}
+
+static void * B_LCInit(double phi, int) { return LC_Init(phi); }
+static void B_LCUpdate(void * s, uint32_t x) { LC_Update((LC_type *) s,x); }
+static ItemMap B_LCOutput(void * s, int t, const std::vector<uint32_t> &)
+	{ return LC_Output((LC_type *) s,t); }
+static int B_LCSize(void * s) { return LC_Size((LC_type *) s); }
+static void B_LCDestroy(void * s) { LC_Destroy((LC_type *) s); }
+
+static void * B_LCDInit(double phi, int) { return LCD_Init(phi); }
+static void B_LCDUpdate(void * s, uint32_t x) { LCD_Update((LCD_type *) s,x); }
+static ItemMap B_LCDOutput(void * s, int t, const std::vector<uint32_t> &)
+	{ return LCD_Output((LCD_type *) s,t); }
+static int B_LCDSize(void * s) { return LCD_Size((LCD_type *) s); }
+static void B_LCDDestroy(void * s) { LCD_Destroy((LCD_type *) s); }
+
+static void * B_LCLInit(double phi, int seed) { return LCL_InitSeed(phi,seed); }
+static void B_LCLUpdate(void * s, uint32_t x) { LCL_Update((LCL_type *) s,x,1); }
+static ItemMap B_LCLOutput(void * s, int t, const std::vector<uint32_t> &)
+	{ return LCL_Output((LCL_type *) s,t); }
+static int B_LCLSize(void * s) { return LCL_Size((LCL_type *) s); }
+static void B_LCLDestroy(void * s) { LCL_Destroy((LCL_type *) s); }
+
+// LCLB: LCL fed through LCL_UpdateBatch, LCL_BATCH items at a time
+// LCLA: through LCL_UpdateBatchAggregate, LCL_AGGBATCH items at a time
+typedef struct {
+	LCL_type * lcl;
+	int n, batch;
+	LCLitem_t buf[LCL_AGGBATCH];
+} B_LCLBatch;
+static void * B_LCLBInit(double phi, int seed)
+{
+	B_LCLBatch * b=(B_LCLBatch *) calloc(1,sizeof(B_LCLBatch));
+	b->lcl=LCL_InitSeed(phi,seed);
+	b->batch=LCL_BATCH;
+	return b;
+}
+static void * B_LCLAInit(double phi, int seed)
+{
+	B_LCLBatch * b=(B_LCLBatch *) B_LCLBInit(phi,seed);
+	b->batch=LCL_AGGBATCH;
+	return b;
+}
+static void B_LCLBFlush(B_LCLBatch * b)
+{
+	if (b->batch==LCL_AGGBATCH)
+		LCL_UpdateBatchAggregate(b->lcl,b->buf,NULL,b->n);
+	else
+		LCL_UpdateBatch(b->lcl,b->buf,NULL,b->n);
+	b->n=0;
+}
+static void B_LCLBUpdate(void * s, uint32_t x)
+{
+	B_LCLBatch * b=(B_LCLBatch *) s;
+	b->buf[b->n++]=x;
+	if (b->n==b->batch) B_LCLBFlush(b);
+}
+static ItemMap B_LCLBOutput(void * s, int t, const std::vector<uint32_t> &)
+{
+	B_LCLBatch * b=(B_LCLBatch *) s;
+	B_LCLBFlush(b);
+	return LCL_Output(b->lcl,t);
+}
+static int B_LCLBSize(void * s) { return LCL_Size(((B_LCLBatch *) s)->lcl); }
+static void B_LCLBDestroy(void * s)
+{
+	LCL_Destroy(((B_LCLBatch *) s)->lcl);
+	free(s);
+}
+
+// LCLK: the fixed-k summary, with the smallest K of 8, 16, 32 or 64 that
+// gives at least 1/phi counters.  It is not run for a smaller phi, where
+// it would answer with fewer counters than the others (see maxk)
+typedef struct {
+	int k;
+	void * lclk;
+} B_LCLK;
+#define B_LCLK_CALL(b, f, ...) \
+	((b)->k==8 ? f((LCLK_type<8> *) (b)->lclk, ##__VA_ARGS__) : \
+	 (b)->k==16 ? f((LCLK_type<16> *) (b)->lclk, ##__VA_ARGS__) : \
+	 (b)->k==32 ? f((LCLK_type<32> *) (b)->lclk, ##__VA_ARGS__) : \
+	 f((LCLK_type<64> *) (b)->lclk, ##__VA_ARGS__))
+static void * B_LCLKInit(double phi, int)
+{
+	B_LCLK * b=(B_LCLK *) calloc(1,sizeof(B_LCLK));
+	for (b->k=8;b->k<LCLK_MAX && b->k*phi<1.0;b->k*=2);
+	if (b->k==8) b->lclk=LCLK_Init<8>();
+	else if (b->k==16) b->lclk=LCLK_Init<16>();
+	else if (b->k==32) b->lclk=LCLK_Init<32>();
+	else b->lclk=LCLK_Init<64>();
+	return b;
+}
+static void B_LCLKUpdate(void * s, uint32_t x)
+{
+	B_LCLK * b=(B_LCLK *) s;
+	switch (b->k)
+	{ // a switch rather than B_LCLK_CALL, as LCL_Update returns nothing
+		case 8: LCL_Update((LCLK_type<8> *) b->lclk,x,1); break;
+		case 16: LCL_Update((LCLK_type<16> *) b->lclk,x,1); break;
+		case 32: LCL_Update((LCLK_type<32> *) b->lclk,x,1); break;
+		default: LCL_Update((LCLK_type<64> *) b->lclk,x,1); break;
+	}
+}
+static ItemMap B_LCLKOutput(void * s, int t, const std::vector<uint32_t> &)
+	{ return B_LCLK_CALL((B_LCLK *) s,LCL_Output,t); }
+static int B_LCLKSize(void * s)
+	{ return sizeof(B_LCLK)+B_LCLK_CALL((B_LCLK *) s,LCL_Size); }
+static void B_LCLKDestroy(void * s)
+{
+	B_LCLK * b=(B_LCLK *) s;
+	free(b->lclk); // LCLK_Init memory is released with free
+	free(b);
+}
+
+static void * B_LCUInit(double phi, int seed) { return LCU_InitSeed(phi,seed); }
+static void B_LCUUpdate(void * s, uint32_t x) { LCU_Update((LCU_type *) s,x); }
+static ItemMap B_LCUOutput(void * s, int t, const std::vector<uint32_t> &)
+	{ return LCU_Output((LCU_type *) s,t); }
+static int B_LCUSize(void * s) { return LCU_Size((LCU_type *) s); }
+static void B_LCUDestroy(void * s) { LCU_Destroy((LCU_type *) s); }
+
+static void * B_QDInit(double phi, int) { return QD_Init(phi,BENCH_LOGU,-1); }
+static void B_QDUpdate(void * s, uint32_t x) { QD_Insert((QD_type *) s,x,1); }
+static ItemMap B_QDOutput(void * s, int t, const std::vector<uint32_t> &)
+{
+	QD_type * qd=(QD_type *) s;
+	if (!qd->a->qhead) return ItemMap(); // still buffering
+	return QD_FindHH(qd,t);
+}
+static int B_QDSize(void * s) { return QD_Size((QD_type *) s); }
+static void B_QDDestroy(void * s) { QD_Destroy((QD_type *) s); }
+
+static void * B_FInit(double phi, int) { return F_Init(phi); }
+static void B_FUpdate(void * s, uint32_t x) { F_Update((F_type *) s,x,1); }
+static ItemMap B_FOutput(void * s, int t, const std::vector<uint32_t> &)
+	{ return F_Output((F_type *) s,t); }
+static int B_FSize(void * s) { return F_Size((F_type *) s); }
+static void B_FDestroy(void * s) { F_Destroy((F_type *) s); }
+
+static void * B_CMInit(double phi, int seed)
+	{ return CM_Init((int) (2.0/phi),4,seed); }
+static void B_CMUpdate(void * s, uint32_t x) { CM_Update((CM_type *) s,x,1); }
+static int B_CMEst(void * s, uint32_t x) { return CM_PointEst((CM_type *) s,x); }
+static ItemMap B_CMOutput(void * s, int t, const std::vector<uint32_t> & d)
+	{ return SketchOutput(d,t,B_CMEst,s); }
+static int B_CMSize(void * s) { return CM_Size((CM_type *) s); }
+static void B_CMDestroy(void * s) { CM_Destroy((CM_type *) s); }
+
+static void * B_CCFCInit(double phi, int seed)
+	{ return CCFC_Init((int) (4.0/phi),5,seed); }
+static void B_CCFCUpdate(void * s, uint32_t x) { CCFC_Update((CCFC_type *) s,x,1); }
+static int B_CCFCEst(void * s, uint32_t x) { return CCFC_PointEst((CCFC_type *) s,x); }
+static ItemMap B_CCFCOutput(void * s, int t, const std::vector<uint32_t> & d)
+	{ return SketchOutput(d,t,B_CCFCEst,s); }
+static int B_CCFCSize(void * s) { return CCFC_Size((CCFC_type *) s); }
+static void B_CCFCDestroy(void * s) { CCFC_Destroy((CCFC_type *) s); }
+
+static void * B_CGTInit(double phi, int seed)
+	{ return CGT_Init((int) (2.0/phi),4,BENCH_LOGU,seed); }
+static void B_CGTUpdate(void * s, uint32_t x) { CGT_Update((CGT_type *) s,x,1); }
+static ItemMap B_CGTOutput(void * s, int t, const std::vector<uint32_t> &)
+	{ return CGT_Output((CGT_type *) s,t); }
+static int B_CGTSize(void * s) { return CGT_Size((CGT_type *) s); }
+static void B_CGTDestroy(void * s) { CGT_Destroy((CGT_type *) s); }
+
+#define BENCH_ENGINE(name, p) \
+	{ name, B_##p##Init, B_##p##Update, B_##p##Output, B_##p##Size, B_##p##Destroy, 0 }
+
+static BenchEngine engines[] = {
+	BENCH_ENGINE("LC",LC),
+	BENCH_ENGINE("LCD",LCD),
+	BENCH_ENGINE("LCL",LCL),
+	BENCH_ENGINE("LCLB",LCLB),
+	{ "LCLA", B_LCLAInit, B_LCLBUpdate, B_LCLBOutput, B_LCLBSize, B_LCLBDestroy, 0 },
+	{ "LCLK", B_LCLKInit, B_LCLKUpdate, B_LCLKOutput, B_LCLKSize, B_LCLKDestroy,
+		LCLK_MAX },
+	BENCH_ENGINE("LCU",LCU),
+	BENCH_ENGINE("QD",QD),
+	BENCH_ENGINE("F",F),
+	BENCH_ENGINE("CM",CM),
+	BENCH_ENGINE("CCFC",CCFC),
+	BENCH_ENGINE("CGT",CGT),
+};
+#define BENCH_ENGINES (int) (sizeof(engines)/sizeof(engines[0]))
+
+/******************************************************************/
+// Timing
+
+static double nspertick=1.0;
+static unsigned long long tickoverhead=0;
+
+static void CalibrateTSC()
+{ // estimate the length of an rdtsc tick in nanoseconds
+	std::chrono::steady_clock::time_point t0, t1;
+	unsigned long long c0, c1;
+	double ns;
+
+	t0=std::chrono::steady_clock::now();
+	c0=__rdtsc();
+	do {
+		t1=std::chrono::steady_clock::now();
+	} while (std::chrono::duration<double,std::nano>(t1-t0).count()<50e6);
+	c1=__rdtsc();
+	ns=std::chrono::duration<double,std::nano>(t1-t0).count();
+	nspertick=ns/(double) (c1-c0);
+
+	// the cost of the timing itself, taken off every per-update sample
+	unsigned int aux;
+	tickoverhead=ULLONG_MAX;
+	for (int i=0;i<10000;i++)
+	{
+		c0=__rdtscp(&aux);
+		c1=__rdtscp(&aux);
+		tickoverhead=(std::min)(tickoverhead,c1-c0);
+	}
+}
+
+static double Seconds(std::chrono::steady_clock::time_point t0)
+{
+	return std::chrono::duration<double>(
+		std::chrono::steady_clock::now()-t0).count();
+}
+
+static double Percentile(std::vector<uint32_t> & ticks, double p)
+{
+	size_t k;
+	if (ticks.empty()) return 0.0;
+	k=(size_t) (p*(ticks.size()-1));
+	std::nth_element(ticks.begin(),ticks.begin()+k,ticks.end());
+	return ticks[k]*nspertick;
+}
+
+/******************************************************************/
+// Streams
+
+typedef struct bench_stream_t {
+	std::string name;
+	double skew;
+	std::vector<uint32_t> items;
+} BenchStream;
+
+static void MakePRGZipf(BenchStream & s, int n, double skew, int seed)
+{
+	Tools::Random rnd(seed);
+	Tools::PRGZipf zipf(1,BENCH_DOMAIN,skew,&rnd);
+	s.name="prgzipf";
+	s.skew=skew;
+	s.items.resize(n);
+	for (int i=0;i<n;i++)
+		s.items[i]=(uint32_t) zipf.nextLong();
+}
+
+static void MakeFastZipf(BenchStream & s, int n, double skew, int seed)
+{
+	prng_type * prng=prng_Init(-seed,2);
+	double zetan=zeta(BENCH_DOMAIN,skew);
+	s.name="fastzipf";
+	s.skew=skew;
+	s.items.resize(n);
+	for (int i=0;i<n;i++)
+		s.items[i]=(uint32_t) fastzipf(skew,BENCH_DOMAIN,zetan,prng);
+	prng_Destroy(prng);
+}
+
+static void MakeUniform(BenchStream & s, int n, int seed)
+{
+	Tools::Random rnd(seed);
+	s.name="uniform";
+	s.skew=0.0;
+	s.items.resize(n);
+	for (int i=0;i<n;i++)
+		s.items[i]=rnd.nextUniformUnsignedLong(1,BENCH_DOMAIN);
+}
+
+static void MakeAdversarial(BenchStream & s, int n, double phi)
+{
+	// one item at twice the threshold; the rest cycle through 2/phi
+	// distinct items, each just below the threshold, so that every
+	// counter based summary is kept busy evicting
+	int cycle=(int) (2.0/phi), gap=(int) (0.5/phi), j=0;
+	s.name="adversarial";
+	s.skew=0.0;
+	s.items.resize(n);
+	for (int i=0;i<n;i++)
+		s.items[i]=(i%gap==0) ? 1 : 2+(j++%cycle);
+}
+
+/******************************************************************/
+
+static void RunEngine(BenchEngine * e, BenchStream & s, double phi, int seed,
+					  const std::unordered_map<uint32_t,int> & exact,
+					  const std::vector<uint32_t> & distinct)
+{
+	std::vector<uint32_t> ticks;
+	std::chrono::steady_clock::time_point t0;
+	unsigned long long c0, c1;
+	unsigned int aux;
+	double secs;
+	int thresh, truehh, found, right, bytes;
+	size_t i, n=s.items.size();
+	void * sk;
+	ItemMap out;
+
+	// pass one: throughput, with no timing inside the loop
+	sk=e->init(phi,seed);
+	t0=std::chrono::steady_clock::now();
+	for (i=0;i<n;i++)
+		e->update(sk,s.items[i]);
+	secs=Seconds(t0);
+	e->destroy(sk);
+
+	// pass two: time each update on its own, and check the answers
+	ticks.resize(n);
+	sk=e->init(phi,seed);
+	for (i=0;i<n;i++)
+	{
+		c0=__rdtscp(&aux);
+		e->update(sk,s.items[i]);
+		c1=__rdtscp(&aux);
+		c1-=(std::min)(c1-c0,tickoverhead);
+		ticks[i]=(uint32_t) (std::min)(c1-c0,(unsigned long long) UINT_MAX);
+	}
+	bytes=e->size(sk);
+	thresh=(int) (phi*n);
+	if (thresh<1) thresh=1;
+	out=e->output(sk,thresh,distinct);
+	e->destroy(sk);
+
+	truehh=0;
+	for (std::unordered_map<uint32_t,int>::const_iterator it=exact.begin();
+		 it!=exact.end();++it)
+		if (it->second>=thresh) truehh++;
+	found=(int) out.size();
+	right=0;
+	for (ItemMap::iterator it=out.begin();it!=out.end();++it)
+	{
+		std::unordered_map<uint32_t,int>::const_iterator x=exact.find(it->first);
+		if (x!=exact.end() && x->second>=thresh) right++;
+	}
+
+	printf("{\"engine\":\"%s\",\"stream\":\"%s\",\"skew\":%g,\"phi\":%g,"
+		"\"n\":%lu,\"updates_per_sec\":%.0f,\"ns_mean\":%.2f,"
+		"\"ns_p50\":%.1f,\"ns_p90\":%.1f,\"ns_p99\":%.1f,\"ns_p999\":%.1f,"
+		"\"ns_max\":%.1f,\"bytes\":%d,\"true_hh\":%d,\"reported\":%d,"
+		"\"recall\":%.4f,\"precision\":%.4f}\n",
+		e->name,s.name.c_str(),s.skew,phi,(unsigned long) n,n/secs,
+		secs*1e9/n,
+		Percentile(ticks,0.5),Percentile(ticks,0.9),Percentile(ticks,0.99),
+		Percentile(ticks,0.999),Percentile(ticks,1.0),bytes,truehh,found,
+		(truehh>0)?(double) right/truehh:1.0,
+		(found>0)?(double) right/found:1.0);
+	fflush(stdout);
+}
+
+static void RunStream(BenchStream & s, double phi, int seed,
+					  const std::vector<std::string> & want)
+{
+	std::unordered_map<uint32_t,int> exact;
+	std::vector<uint32_t> distinct;
+	int e;
+
+	for (size_t i=0;i<s.items.size();i++)
+		exact[s.items[i]]++;
+	distinct.reserve(exact.size());
+	for (std::unordered_map<uint32_t,int>::iterator it=exact.begin();
+		 it!=exact.end();++it)
+		distinct.push_back(it->first);
+	for (e=0;e<BENCH_ENGINES;e++)
+	{
+		if (!want.empty() &&
+			std::find(want.begin(),want.end(),engines[e].name)==want.end())
+			continue;
+		if (engines[e].maxk>0 && engines[e].maxk*phi<1.0)
+		{ // a row at this phi would not compare like with like
+			fprintf(stderr,"skipping %s: it has at most %d counters, fewer "
+				"than 1/phi\n",engines[e].name,engines[e].maxk);
+			continue;
+		}
+		RunEngine(&engines[e],s,phi,seed,exact,distinct);
+	}
+}
+
+/******************************************************************/
+// Quantiles: GK against q-digest
+
+static void RunQuantiles(const char * name, std::vector<double> & vals,
+						 double eps, const std::vector<std::string> & want)
+{
+	static const double phis[]={0.5,0.9,0.99,0.999};
+	const int nphi=4;
+	std::vector<double> sorted(vals);
+	std::vector<uint32_t> ivals(vals.size());
+	std::chrono::steady_clock::time_point t0;
+	double secs, gkout[nphi], err, maxerr;
+	unsigned int qdout[nphi];
+	size_t i, n=vals.size();
+	int p, batch=4096;
+
+	std::sort(sorted.begin(),sorted.end());
+	for (i=0;i<n;i++) // q-digest needs integers: microseconds, clamped
+		ivals[i]=(uint32_t) (std::min)(vals[i],(double) ((1<<BENCH_QLOGU)-1));
+
+	for (int which=0;which<3;which++)
+	{
+		const char * ename=(which==0)?"GK":(which==1)?"GKB":"QD";
+		if (!want.empty() &&
+			std::find(want.begin(),want.end(),ename)==want.end())
+			continue;
+		GK_type * gk=NULL;
+		QD_type * qd=NULL;
+		t0=std::chrono::steady_clock::now();
+		if (which==0) {
+			gk=GK_Init(eps);
+			for (i=0;i<n;i++) GK_Insert(gk,vals[i]);
+		} else if (which==1) {
+			gk=GK_Init(eps);
+			for (i=0;i<n;i+=batch)
+				GK_InsertBatch(gk,&vals[i],(int) (std::min)((size_t) batch,n-i));
+		} else {
+			qd=QD_Init(eps,BENCH_QLOGU,-1);
+			for (i=0;i<n;i++) QD_Insert(qd,ivals[i],1);
+		}
+		secs=Seconds(t0);
+		if (gk) GK_OutputQuantiles(gk,phis,nphi,gkout);
+		else QD_OutputQuantiles(qd,phis,nphi,qdout);
+		maxerr=0.0;
+		for (p=0;p<nphi;p++)
+		{ // how far is the rank of the answer from the requested rank
+			double v=(gk)?gkout[p]:(double) qdout[p];
+			double lo=(double) (std::lower_bound(sorted.begin(),sorted.end(),v)
+				-sorted.begin())/n;
+			double hi=(double) (std::upper_bound(sorted.begin(),sorted.end(),v)
+				-sorted.begin())/n;
+			err=(phis[p]<lo)?lo-phis[p]:(phis[p]>hi)?phis[p]-hi:0.0;
+			if (err>maxerr) maxerr=err;
+		}
+		printf("{\"engine\":\"%s\",\"stream\":\"%s\",\"skew\":0,\"phi\":%g,"
+			"\"n\":%lu,\"updates_per_sec\":%.0f,\"ns_mean\":%.2f,\"bytes\":%d,"
+			"\"max_rank_error\":%.5f}\n",
+			ename,name,eps,(unsigned long) n,n/secs,secs*1e9/n,
+			(gk)?GK_Size(gk):QD_Size(qd),maxerr);
+		fflush(stdout);
+		if (gk) GK_Destroy(gk);
+		if (qd) QD_Destroy(qd);
+	}
+}
+
+static void MakeLatencies(std::vector<double> & vals, int n, int bimodal,
+						  int seed)
+{
+	// lognormal latencies around 400us, or a fast path around 150us with
+	// a slow mode around 20ms
+	prng_type * prng=prng_Init(-seed,2);
+	vals.resize(n);
+	for (int i=0;i<n;i++)
+	{
+		if (bimodal && prng_float(prng)<0.05)
+			vals[i]=exp(log(20000.0)+0.5*prng_normal(prng));
+		else
+			vals[i]=exp(log(bimodal?150.0:400.0)+0.8*prng_normal(prng));
+	}
+	prng_Destroy(prng);
+}
+
+/******************************************************************/
+
+static void Split(const char * arg, std::vector<std::string> & out)
+{
+	std::stringstream ss(arg);
+	std::string tok;
+	while (std::getline(ss,tok,','))
+		if (!tok.empty()) out.push_back(tok);
+}
+
+int main(int argc, char ** argv)
+{
+	std::vector<std::string> want, phiargs;
+	std::vector<double> phis, lat;
+	static const double skews[]={0.8,1.1,1.5};
+	int n=1000000, seed=1, c, k;
+	size_t p;
+
+	while ((c=getopt(argc,argv,"n:s:e:p:"))!=-1)
+	{
+		switch (c)
+		{
+		case 'n': n=atoi(optarg); break;
+		case 's': seed=atoi(optarg); break;
+		case 'e': Split(optarg,want); break;
+		case 'p': Split(optarg,phiargs); break;
+		default:
+			fprintf(stderr,"usage: %s [-n updates] [-s seed] "
+				"[-e engine,...] [-p phi,...]\n",argv[0]);
+			return 1;
+		}
+	}
+	for (p=0;p<phiargs.size();p++)
+		phis.push_back(atof(phiargs[p].c_str()));
+	if (phis.empty())
+	{
+		phis.push_back(1e-2);
+		phis.push_back(1e-3);
+		phis.push_back(1e-4);
+	}
+	CalibrateTSC();
+
+	for (p=0;p<phis.size();p++)
+	{
+		BenchStream s;
+		for (k=0;k<3;k++)
+		{
+			MakePRGZipf(s,n,skews[k],seed);
+			RunStream(s,phis[p],seed,want);
+			MakeFastZipf(s,n,skews[k],seed);
+			RunStream(s,phis[p],seed,want);
+		}
+		MakeUniform(s,n,seed);
+		RunStream(s,phis[p],seed,want);
+		MakeAdversarial(s,n,phis[p]);
+		RunStream(s,phis[p],seed,want);
+	}
+
+	MakeLatencies(lat,n,0,seed);
+	for (p=0;p<phis.size();p++)
+		RunQuantiles("lognormal",lat,phis[p],want);
+	MakeLatencies(lat,n,1,seed);
+	for (p=0;p<phis.size();p++)
+		RunQuantiles("bimodal",lat,phis[p],want);
+	return 0;
+}
@@ -0,0 +1,56 @@
+#!/usr/bin/env python
+# compare two benchmark runs (JSON lines from bench/bench) and flag
+# throughput, latency or accuracy regressions
+#
+# usage: compare.py baseline.jsonl current.jsonl [tolerance]
+
+import json
+import sys
+
+
+def load(path):
+  res = {}
+  with open(path) as f:
+    for line in f:
+      line = line.strip()
+      if not line.startswith('{'):
+        continue
+      r = json.loads(line)
+      res[(r['engine'], r['stream'], r['skew'], r['phi'], r['n'])] = r
+  return res
+
+
+def main():
+  if len(sys.argv) < 3:
+    print("usage: %s baseline.jsonl current.jsonl [tolerance]" % sys.argv[0])
+    return 2
+  old = load(sys.argv[1])
+  new = load(sys.argv[2])
+  tol = float(sys.argv[3]) if len(sys.argv) > 3 else 0.10
+  bad = 0
+  for key in sorted(old, key=str):
+    if key not in new:
+      continue
+    a, b = old[key], new[key]
+    notes = []
+    ratio = b['updates_per_sec'] / a['updates_per_sec']
+    if ratio < 1.0 - tol:
+      notes.append("throughput %.0f%%" % (100 * (ratio - 1)))
+    if 'ns_p999' in a and b['ns_p999'] > a['ns_p999'] * (1.0 + tol) + 50:
+      notes.append("p99.9 %.0fns -> %.0fns" % (a['ns_p999'], b['ns_p999']))
+    for m in ('recall', 'precision'):
+      if m in a and b[m] < a[m] - 0.01:
+        notes.append("%s %.3f -> %.3f" % (m, a[m], b[m]))
+    if 'max_rank_error' in a and b['max_rank_error'] > a['max_rank_error'] + 1e-4:
+      notes.append("rank error %.5f -> %.5f" %
+                   (a['max_rank_error'], b['max_rank_error']))
+    print("%-6s %-12s skew=%-4g phi=%-7g %6.2fx %s" %
+          (key[0], key[1], key[2], key[3], ratio, "; ".join(notes)))
+    if notes:
+      bad += 1
+  print("%d regression(s)" % bad)
+  return 1 if bad else 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
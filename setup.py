@@ -1,3 +1,4 @@
+import os
 import sys
 from setuptools import setup, Extension
 from os.path import join, abspath, dirname
@@ -11,11 +12,11 @@ with open(
 """
 CXXFLAGS=-O2 -DNDEBUG -fPIC
 CXX=g+
-OBJECTS=rand48.o qdigest.o prng.o lossycount.o gk.o frequent.o countmin.o cgt.o ccfc.o
+OBJECTS=rand48.o qdigest.o prng.o lossycount.o gk.o frequent.o lclpool.o persist.o lclshare.o lcldecay.o lclwindow.o lclchange.o lclhhh.o lclquant.o rollup.o countmin.o cgt.o ccfc.o stats.o
 all: $(OBJECTS)
-    $(CXX) $(CXXFLAGS) -shared wrap.cc $(OBJECTS) -o Release/lossycount.so -lboost_python
+    $(CXX) $(CXXFLAGS) -shared wrap.cc $(OBJECTS) -o Release/lossycount.so -lboost_python -lrt
     rm -rf *.o
-$(OBJECTS): rand48.h qdigest.h prng.h lossycount.h gk4.h frequent.h countmin.h cgt.h ccfc.h
+$(OBJECTS): rand48.h qdigest.h prng.h lossycount.h gk4.h frequent.h lclpool.h smallscan.h persist.h lclshare.h lcldecay.h lclwindow.h lclchange.h lclhhh.h lclquant.h rollup.h countmin.h cgt.h ccfc.h stats.h
     $(CXX) $(CXXFLAGS) -c $*.cc
 """
 setup(
@@ -34,16 +35,43 @@ setup(
         'src/rand48.cc',
         'src/qdigest.cc',
         'src/prng.cc',
-        'src/lossycount.cc'
+        'src/lossycount.cc',
+        'src/countmin.cc',
+        'src/gk.cc',
+        'src/cgt.cc',
+        'src/ccfc.cc',
+        'src/frequent.cc',
+        'src/lclpool.cc',
+        'src/persist.cc',
+        'src/lclshare.cc',
+        'src/lcldecay.cc',
+        'src/lclwindow.cc',
+        'src/lclchange.cc',
+        'src/lclhhh.cc',
+        'src/lclquant.cc',
+        'src/rollup.cc',
+        'src/stats.cc'
       ],
+      # LOSSYCOUNT_COUNTERS=1 builds in counts of updates and slow-path
+      # events, LOSSYCOUNT_STATS=1 per-update latency histograms as well;
+      # both are read back with .stats().  LOSSYCOUNT_PAYLOAD=1 gives the
+      # counters of LossyCount a sum/min/max payload (LCL_PAYLOAD)
+      define_macros=([('SKETCH_STATS', None)]
+      if os.environ.get('LOSSYCOUNT_STATS') else
+      [('SKETCH_COUNTERS', None)]
+      if os.environ.get('LOSSYCOUNT_COUNTERS') else [])+
+      ([('LCL_PAYLOAD', None)] if os.environ.get('LOSSYCOUNT_PAYLOAD') else []),
       extra_compile_args=[
         '-O3',
         '-pipe',
         '-DNDEBUG',
         '-fomit-frame-pointer',
+        '-pthread',
       ],
+      extra_link_args=['-pthread'], # persist.cc and rollup.cc write from a thread
       libraries=[
-        'boost_python%s%s' % sys.version_info[:2]
+        'boost_python%s%s' % sys.version_info[:2],
+        'rt', # shm_open, for lclshare.cc
       ],
       language='c++',
     ),
@@ -0,0 +1,216 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "ccfc.h"
+#include "prng.h"
+/********************************************************************
+Implementation of the Count Sketch to estimate item frequencies
+Based on the paper of Charikar, Chen and Farach-Colton, 2002
+Each row maps an item to one counter with a pairwise hash31
+function and adds or subtracts its weight according to a 4-wise
+independent sign.  Each row gives an unbiased estimate, and the
+median of the rows is taken; the product of two sketches built with
+the same hash functions estimates the join size of their streams.
+
+This work is licensed under the Creative Commons
+Attribution-NonCommercial License. To view a copy of this license,
+visit http://creativecommons.org/licenses/by-nc/1.0/ or send a letter
+to Creative Commons, 559 Nathan Abbott Way, Stanford, California
+94305, USA.
+*********************************************************************/
+
+CCFC_type * CCFC_Init(int width, int depth, int seed)
+{
+	CCFC_type * ccfc;
+	prng_type * prng;
+	int j;
+
+	if (width<1) width=1;
+	if (depth<1) depth=1;
+	prng=prng_Init(-abs(seed),2);
+
+	ccfc=(CCFC_type *) calloc(1,sizeof(CCFC_type));
+	ccfc->depth=depth;
+	ccfc->width=width;
+	ccfc->count=0;
+	ccfc->counts=(int **) calloc(depth,sizeof(int *));
+	ccfc->counts[0]=(int *) calloc(depth*width,sizeof(int));
+	ccfc->hasha=(unsigned int *) calloc(6*depth,sizeof(unsigned int));
+	if (!(ccfc->counts && ccfc->counts[0] && ccfc->hasha))
+	{
+		fprintf(stderr,"Out of memory error allocating %d counters\n",
+			depth*width);
+		exit(1);
+	}
+	// all six sets of hash parameters share one allocation
+	ccfc->hashb=ccfc->hasha+depth;
+	ccfc->hashc=ccfc->hashb+depth;
+	ccfc->hashd=ccfc->hashc+depth;
+	ccfc->hashe=ccfc->hashd+depth;
+	ccfc->hashf=ccfc->hashe+depth;
+	for (j=0;j<depth;j++)
+	{
+		ccfc->hasha[j]=prng_int(prng) & MOD;
+		ccfc->hashb[j]=prng_int(prng) & MOD;
+		ccfc->hashc[j]=prng_int(prng) & MOD;
+		ccfc->hashd[j]=prng_int(prng) & MOD;
+		ccfc->hashe[j]=prng_int(prng) & MOD;
+		ccfc->hashf[j]=prng_int(prng) & MOD;
+		ccfc->counts[j]=ccfc->counts[0]+j*width;
+	}
+	prng_Destroy(prng);
+	return ccfc;
+}
+
+void CCFC_Destroy(CCFC_type * ccfc)
+{
+	if (!ccfc) return;
+	free(ccfc->hasha);
+	free(ccfc->counts[0]);
+	free(ccfc->counts);
+	free(ccfc);
+}
+
+int CCFC_Size(CCFC_type * ccfc)
+{ // return the size of the sketch in bytes
+	if (!ccfc) return 0;
+	return sizeof(CCFC_type) + ccfc->depth*6*sizeof(unsigned int) +
+		ccfc->depth*sizeof(int *) + ccfc->depth*ccfc->width*sizeof(int);
+}
+
+static inline int CCFC_Bucket(CCFC_type * ccfc, int j, unsigned int item)
+{
+	return (int) (hash31(ccfc->hasha[j],ccfc->hashb[j],item) % ccfc->width);
+}
+
+static inline int CCFC_Sign(CCFC_type * ccfc, int j, unsigned int item)
+{ // +1 or -1
+	return (int) ((fourwise(ccfc->hashc[j],ccfc->hashd[j],ccfc->hashe[j],
+		ccfc->hashf[j],item) & 1) << 1) - 1;
+}
+
+void CCFC_Update(CCFC_type * ccfc, unsigned int item, int diff)
+{
+	int j;
+
+	if (!ccfc) return;
+	ccfc->count+=diff;
+	for (j=0;j<ccfc->depth;j++)
+		ccfc->counts[j][CCFC_Bucket(ccfc,j,item)]+=CCFC_Sign(ccfc,j,item)*diff;
+}
+
+static void CCFC_HashBlock(CCFC_type * ccfc, int j, const unsigned int * items,
+						   const int * diffs, unsigned int * buckets,
+						   int * vals, int n)
+{
+	// compute the row j bucket and signed weight for a block of items,
+	// with the batch hash routines.  The modulus is done in a separate
+	// pass since integer division does not vectorize.
+	unsigned int signs[CCFC_BATCH];
+	int i;
+
+	hash31_batch(ccfc->hasha[j],ccfc->hashb[j],items,buckets,n);
+	fourwise_batch(ccfc->hashc[j],ccfc->hashd[j],ccfc->hashe[j],
+		ccfc->hashf[j],items,signs,n);
+	for (i=0;i<n;i++)
+		vals[i]=(int) ((signs[i]&1)<<1)-1;
+	if (diffs)
+		for (i=0;i<n;i++)
+			vals[i]*=diffs[i];
+	for (i=0;i<n;i++)
+		buckets[i]%=ccfc->width;
+}
+
+void CCFC_UpdateBatch(CCFC_type * ccfc, const unsigned int * items,
+					  const int * diffs, int n)
+{
+	// process the batch in blocks, one row at a time: hash the block,
+	// then scatter the signed weights into the row
+	unsigned int buckets[CCFC_BATCH];
+	int vals[CCFC_BATCH];
+	int i, j, m, off;
+	int * row;
+
+	if (!ccfc) return;
+	for (off=0;off<n;off+=CCFC_BATCH)
+	{
+		m=(n-off<CCFC_BATCH) ? n-off : CCFC_BATCH;
+		for (j=0;j<ccfc->depth;j++)
+		{
+			CCFC_HashBlock(ccfc,j,items+off,(diffs)?diffs+off:NULL,
+				buckets,vals,m);
+			row=ccfc->counts[j];
+			for (i=0;i<m;i++)
+				row[buckets[i]]+=vals[i];
+		}
+		if (diffs)
+			for (i=0;i<m;i++)
+				ccfc->count+=diffs[off+i];
+		else
+			ccfc->count+=m;
+	}
+}
+
+int CCFC_PointEst(CCFC_type * ccfc, unsigned int item)
+{
+	// each row gives an unbiased estimate; return their median
+	int ests[65], *e, j, ans;
+
+	if (!ccfc) return 0;
+	e=(ccfc->depth<65) ? ests : (int *) malloc((ccfc->depth+1)*sizeof(int));
+	for (j=0;j<ccfc->depth;j++)
+		e[j+1]=ccfc->counts[j][CCFC_Bucket(ccfc,j,item)]*CCFC_Sign(ccfc,j,item);
+	if (ccfc->depth==1) ans=e[1];
+	else if (ccfc->depth==2) ans=(e[1]+e[2])/2;
+	else ans=MedSelect(1+ccfc->depth/2,ccfc->depth,e);
+	if (e!=ests) free(e);
+	return ans;
+}
+
+long long CCFC_InnerProd(CCFC_type * ccfc1, CCFC_type * ccfc2)
+{
+	// the product of two rows is an unbiased estimate of the inner
+	// product of the two frequency vectors; return the median of rows.
+	// returns 0 if the sketches do not share hash functions
+	int64_t ests[65], *e;
+	long long ans;
+	int i, j;
+	int * r1, * r2;
+
+	if (!CCFC_Compatible(ccfc1,ccfc2)) return 0;
+	e=(ccfc1->depth<65) ? ests :
+		(int64_t *) malloc((ccfc1->depth+1)*sizeof(int64_t));
+	for (j=0;j<ccfc1->depth;j++)
+	{
+		r1=ccfc1->counts[j];
+		r2=ccfc2->counts[j];
+		e[j+1]=0;
+		for (i=0;i<ccfc1->width;i++)
+			e[j+1]+=((int64_t) r1[i])*r2[i];
+	}
+	if (ccfc1->depth==1) ans=e[1];
+	else if (ccfc1->depth==2) ans=(e[1]+e[2])/2;
+	else ans=LLMedSelect(1+ccfc1->depth/2,ccfc1->depth,e);
+	if (e!=ests) free(e);
+	return ans;
+}
+
+int CCFC_Compatible(CCFC_type * a, CCFC_type * b)
+{ // test whether two sketches have the same width, depth and hashes
+	if (!a || !b) return 0;
+	if (a->width!=b->width || a->depth!=b->depth) return 0;
+	return memcmp(a->hasha,b->hasha,6*a->depth*sizeof(unsigned int))==0;
+}
+
+int CCFC_Merge(CCFC_type * a, CCFC_type * b)
+{
+	// add the counts of b into a; both must use the same hash functions
+	int i, total;
+
+	if (!CCFC_Compatible(a,b)) return 0;
+	total=a->depth*a->width;
+	for (i=0;i<total;i++)
+		a->counts[0][i]+=b->counts[0][i];
+	a->count+=b->count;
+	return 1;
+}
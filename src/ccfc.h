@@ -0,0 +1,40 @@
+// ccfc.h -- header file for the Count Sketch
+// see Charikar, Chen & Farach-Colton, ICALP 2002 for details
+
+#ifndef CCFC_h
+#define CCFC_h
+
+#include "prng.h"
+
+#define CCFC_BATCH 256 // number of items hashed together in the batch routines
+
+typedef struct CCFC_type{
+  long long count;   // total weight of updates received
+  int depth;         // number of rows (independent estimates)
+  int width;         // number of counters in each row
+  int ** counts;     // counts[j] points into one contiguous depth*width block
+  unsigned int *hasha, *hashb; // hash31 parameters picking the bucket
+  unsigned int *hashc, *hashd, *hashe, *hashf; // fourwise parameters
+                                               // picking the sign
+} CCFC_type;
+
+extern CCFC_type * CCFC_Init(int, int, int);
+// initialize with width, depth and a seed for the hash functions
+extern void CCFC_Destroy(CCFC_type *);
+extern int CCFC_Size(CCFC_type *); // size of the sketch in bytes
+
+extern void CCFC_Update(CCFC_type *, unsigned int, int);
+extern void CCFC_UpdateBatch(CCFC_type *, const unsigned int *, const int *,
+                             int);
+// batched update: items, weights (NULL for all ones), number of items
+
+extern int CCFC_PointEst(CCFC_type *, unsigned int);
+// unbiased estimate of an item's count: median over the rows
+extern long long CCFC_InnerProd(CCFC_type *, CCFC_type *);
+// estimate the inner product (join size) of the two streams
+
+extern int CCFC_Compatible(CCFC_type *, CCFC_type *);
+extern int CCFC_Merge(CCFC_type *, CCFC_type *);
+// add the second sketch into the first; returns 0 if not compatible
+
+#endif
@@ -0,0 +1,249 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "cgt.h"
+#include "prng.h"
+/********************************************************************
+Implementation of Combinatorial Group Testing to find Frequent Items
+Based on the paper of Cormode and Muthukrishnan, 2003
+Each test hashes items into groups.  A group keeps its total count
+and, for every bit of the item identifier, the count of the items in
+the group with that bit set.  A group dominated by one heavy item
+spells out that item's identifier bit by bit.
+
+The sketch is linear, so it handles arbitrary insertions and
+deletions (turnstile streams) and two sketches with the same
+parameters can be added together.
+
+This work is licensed under the Creative Commons
+Attribution-NonCommercial License. To view a copy of this license,
+visit http://creativecommons.org/licenses/by-nc/1.0/ or send a letter
+to Creative Commons, 559 Nathan Abbott Way, Stanford, California
+94305, USA.
+*********************************************************************/
+
+CGT_type * CGT_Init(int buckets, int tests, int lgn, int seed)
+{
+	CGT_type * cgt;
+	prng_type * prng;
+	int i;
+
+	if (buckets<1) buckets=1;
+	if (tests<1) tests=1;
+	if (lgn<1 || lgn>32) lgn=32;
+	prng=prng_Init(-abs(seed),2);
+
+	cgt=(CGT_type *) calloc(1,sizeof(CGT_type));
+	cgt->tests=tests;
+	cgt->logn=lgn;
+	cgt->buckets=buckets;
+	cgt->count=0;
+	cgt->totals=(int *) calloc(tests*buckets,sizeof(int));
+	cgt->bits=(int *) calloc(tests*buckets*lgn,sizeof(int));
+	cgt->testa=(unsigned int *) calloc(tests,sizeof(unsigned int));
+	cgt->testb=(unsigned int *) calloc(tests,sizeof(unsigned int));
+	if (!(cgt->totals && cgt->bits && cgt->testa && cgt->testb))
+	{
+		fprintf(stderr,"Out of memory error allocating %d counters\n",
+			tests*buckets*(lgn+1));
+		exit(1);
+	}
+	for (i=0;i<tests;i++)
+	{
+		cgt->testa[i]=prng_int(prng) & MOD;
+		cgt->testb[i]=prng_int(prng) & MOD;
+		// pick the hash functions
+	}
+	prng_Destroy(prng);
+	return cgt;
+}
+
+void CGT_Destroy(CGT_type * cgt)
+{
+	if (!cgt) return;
+	free(cgt->totals);
+	free(cgt->bits);
+	free(cgt->testa);
+	free(cgt->testb);
+	free(cgt);
+}
+
+int CGT_Size(CGT_type * cgt)
+{ // return the size of the sketch in bytes
+	if (!cgt) return 0;
+	return sizeof(CGT_type) + cgt->tests*2*sizeof(unsigned int) +
+		cgt->tests*cgt->buckets*(cgt->logn+1)*sizeof(int);
+}
+
+static inline void CGT_AddToGroup(CGT_type * cgt, int group,
+								  unsigned int item, int diff)
+{
+	// add diff to the group total and to the counter of each set bit.
+	// written without branches so that the bit loop vectorizes
+	int * bpt;
+	int i;
+
+	cgt->totals[group]+=diff;
+	bpt=cgt->bits+group*cgt->logn;
+	for (i=0;i<cgt->logn;i++)
+		bpt[i]+=diff & -(int) ((item>>i)&1);
+}
+
+void CGT_Update(CGT_type * cgt, unsigned int item, int diff)
+{
+	int i, b;
+
+	if (!cgt) return;
+	cgt->count+=diff;
+	for (i=0;i<cgt->tests;i++)
+	{
+		b=hash31(cgt->testa[i],cgt->testb[i],item) % cgt->buckets;
+		CGT_AddToGroup(cgt,i*cgt->buckets+b,item,diff);
+	}
+}
+
+static void CGT_HashBlock(CGT_type * cgt, int t, const unsigned int * items,
+						  unsigned int * buckets, int n)
+{
+	// hash31 for test t over a block of items (see CM_HashBlock)
+	int i;
+
+	hash31_batch(cgt->testa[t],cgt->testb[t],items,buckets,n);
+	for (i=0;i<n;i++)
+		buckets[i]%=cgt->buckets;
+}
+
+void CGT_UpdateBatch(CGT_type * cgt, const unsigned int * items,
+					 const int * diffs, int n)
+{
+	// process the batch in blocks, one test at a time, so that the
+	// counters of one test stay in cache while the block is applied
+	unsigned int buckets[CGT_BATCH];
+	int i, t, m, off, base;
+
+	if (!cgt) return;
+	for (off=0;off<n;off+=CGT_BATCH)
+	{
+		m=(n-off<CGT_BATCH) ? n-off : CGT_BATCH;
+		for (t=0;t<cgt->tests;t++)
+		{
+			CGT_HashBlock(cgt,t,items+off,buckets,m);
+			base=t*cgt->buckets;
+			for (i=0;i<m;i++)
+				CGT_AddToGroup(cgt,base+buckets[i],items[off+i],
+					(diffs) ? diffs[off+i] : 1);
+		}
+		if (diffs)
+			for (i=0;i<m;i++)
+				cgt->count+=diffs[off+i];
+		else
+			cgt->count+=m;
+	}
+}
+
+int CGT_PointEst(CGT_type * cgt, unsigned int item)
+{
+	// the median of the counts of the groups the item falls in.
+	// each is the item's count plus the (net) weight of the others
+	// in the group
+	int ests[65], *e, i, b, ans;
+
+	if (!cgt) return 0;
+	e=(cgt->tests<65) ? ests : (int *) malloc((cgt->tests+1)*sizeof(int));
+	for (i=0;i<cgt->tests;i++)
+	{
+		b=hash31(cgt->testa[i],cgt->testb[i],item) % cgt->buckets;
+		e[i+1]=cgt->totals[i*cgt->buckets+b];
+	}
+	if (cgt->tests==1) ans=e[1];
+	else if (cgt->tests==2) ans=(e[1]+e[2])/2;
+	else ans=MedSelect(1+cgt->tests/2,cgt->tests,e);
+	if (e!=ests) free(e);
+	return ans;
+}
+
+static int CGT_FindOne(CGT_type * cgt, int group, int thresh,
+					   unsigned int * item)
+{
+	// try to read off the identity of a heavy item from its group.
+	// for each bit, exactly one of 'bit set' and 'bit clear' must carry
+	// at least thresh; otherwise the group holds zero or several heavy
+	// items and we give up on it
+	int * bpt;
+	int i, total, one, zero;
+	unsigned int res;
+
+	total=cgt->totals[group];
+	bpt=cgt->bits+group*cgt->logn;
+	res=0;
+	for (i=0;i<cgt->logn;i++)
+	{
+		one=bpt[i];
+		zero=total-one;
+		if (one>=thresh)
+		{
+			if (zero>=thresh) return 0;
+			res|=1u<<i;
+		}
+		else if (zero<thresh) return 0;
+	}
+	*item=res;
+	return 1;
+}
+
+std::map<uint32_t, uint32_t> CGT_Output(CGT_type * cgt, int thresh)
+{
+	// scan the group totals for heavy groups, decode the candidate from
+	// each, and keep it if it really hashes to that group and its
+	// estimated count clears the threshold.  The cost depends only on
+	// the size of the sketch, never on the length of the stream
+	std::map<uint32_t, uint32_t> res;
+	unsigned int item;
+	int t, b, group, est;
+
+	if (!cgt) return res;
+	if (thresh<1) thresh=1;
+	for (t=0;t<cgt->tests;t++)
+		for (b=0;b<cgt->buckets;b++)
+		{
+			group=t*cgt->buckets+b;
+			if (cgt->totals[group]<thresh) continue;
+			if (!CGT_FindOne(cgt,group,thresh,&item)) continue;
+			if (res.count(item)) continue;
+			if (hash31(cgt->testa[t],cgt->testb[t],item) % cgt->buckets
+				!= (unsigned int) b)
+				continue; // decoded an item that does not live here
+			est=CGT_PointEst(cgt,item);
+			if (est>=thresh)
+				res.insert(std::pair<uint32_t, uint32_t>(item, est));
+		}
+	return res;
+}
+
+int CGT_Compatible(CGT_type * a, CGT_type * b)
+{ // test whether two sketches have the same parameters
+	int i;
+
+	if (!a || !b) return 0;
+	if (a->tests!=b->tests || a->buckets!=b->buckets || a->logn!=b->logn)
+		return 0;
+	for (i=0;i<a->tests;i++)
+		if (a->testa[i]!=b->testa[i] || a->testb[i]!=b->testb[i])
+			return 0;
+	return 1;
+}
+
+int CGT_Merge(CGT_type * a, CGT_type * b)
+{
+	// add the counts of b into a; both must use the same hash functions
+	int i, groups;
+
+	if (!CGT_Compatible(a,b)) return 0;
+	groups=a->tests*a->buckets;
+	for (i=0;i<groups;i++)
+		a->totals[i]+=b->totals[i];
+	for (i=0;i<groups*a->logn;i++)
+		a->bits[i]+=b->bits[i];
+	a->count+=b->count;
+	return 1;
+}
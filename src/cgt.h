@@ -0,0 +1,40 @@
+// cgt.h -- header file for Combinatorial Group Testing
+// see Cormode & Muthukrishnan, PODS 2003 for details
+
+#ifndef CGT_h
+#define CGT_h
+
+#include "prng.h"
+
+#define CGT_BATCH 256 // number of items hashed together in the batch routines
+
+typedef struct CGT_type{
+  long long count;  // total weight of updates received (net of deletions)
+  int tests;        // number of independent repetitions
+  int logn;         // number of bits in an item identifier
+  int buckets;      // number of groups in each test
+  int * totals;     // tests*buckets group counts
+  int * bits;       // tests*buckets*logn counts, one per bit of each group
+  unsigned int *testa, *testb; // parameters for hash31, one pair per test
+} CGT_type;
+
+extern CGT_type * CGT_Init(int, int, int, int);
+// initialize with number of buckets, tests, log of the domain size, seed
+extern void CGT_Destroy(CGT_type *);
+extern int CGT_Size(CGT_type *); // size of the sketch in bytes
+
+extern void CGT_Update(CGT_type *, unsigned int, int);
+// weights can be negative: the sketch is linear, so deletions cancel
+extern void CGT_UpdateBatch(CGT_type *, const unsigned int *, const int *, int);
+// batched update: items, weights (NULL for all ones), number of items
+
+extern int CGT_PointEst(CGT_type *, unsigned int);
+// median of the item's group counts
+extern std::map<uint32_t, uint32_t> CGT_Output(CGT_type *, int);
+// recover the items whose count is at least the threshold
+
+extern int CGT_Compatible(CGT_type *, CGT_type *);
+extern int CGT_Merge(CGT_type *, CGT_type *);
+// add the second sketch into the first; returns 0 if not compatible
+
+#endif
@@ -0,0 +1,299 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "countmin.h"
+#include "prng.h"
+/********************************************************************
+Implementation of the Count-Min sketch for point queries
+Based on the paper of Cormode and Muthukrishnan, 2004
+Each of 'depth' rows keeps 'width' counters, and an item is mapped
+to one counter per row by a pairwise independent hash31 function.
+An estimate is the minimum of the item's counters, which never
+underestimates for non-negative streams.
+
+This work is licensed under the Creative Commons
+Attribution-NonCommercial License. To view a copy of this license,
+visit http://creativecommons.org/licenses/by-nc/1.0/ or send a letter
+to Creative Commons, 559 Nathan Abbott Way, Stanford, California
+94305, USA.
+*********************************************************************/
+
+CM_type * CM_Init(int width, int depth, int seed)
+{
+	CM_type * cm;
+	prng_type * prng;
+	int j;
+
+	if (width<1) width=1;
+	if (depth<1) depth=1;
+	prng=prng_Init(-abs(seed),2);
+	// initialize the generator to pick the hash functions
+
+	cm=(CM_type *) calloc(1,sizeof(CM_type));
+	cm->depth=depth;
+	cm->width=width;
+	cm->count=0;
+	cm->counts=(int **) calloc(depth,sizeof(int *));
+	cm->counts[0]=(int *) calloc(depth*width,sizeof(int));
+	// one block of counters, so that a whole sketch can be copied at once
+	cm->hasha=(unsigned int *) calloc(depth,sizeof(unsigned int));
+	cm->hashb=(unsigned int *) calloc(depth,sizeof(unsigned int));
+	if (cm->counts && cm->counts[0] && cm->hasha && cm->hashb)
+	{
+		for (j=0;j<depth;j++)
+		{
+			cm->hasha[j]=prng_int(prng) & MOD;
+			cm->hashb[j]=prng_int(prng) & MOD;
+			// pick the hash functions
+			cm->counts[j]=cm->counts[0]+j*width;
+		}
+	}
+	else
+	{
+		fprintf(stderr,"Out of memory error allocating %d counters\n",
+			depth*width);
+		exit(1);
+	}
+	prng_Destroy(prng);
+	return cm;
+}
+
+CM_type * CM_Copy(CM_type * cmold)
+{ // create a new sketch with the same parameters and counts as cmold
+	CM_type * cm;
+	int j;
+
+	cm=(CM_type *) calloc(1,sizeof(CM_type));
+	cm->depth=cmold->depth;
+	cm->width=cmold->width;
+	cm->count=cmold->count;
+	cm->counts=(int **) calloc(cm->depth,sizeof(int *));
+	cm->counts[0]=(int *) malloc(cm->depth*cm->width*sizeof(int));
+	cm->hasha=(unsigned int *) malloc(cm->depth*sizeof(unsigned int));
+	cm->hashb=(unsigned int *) malloc(cm->depth*sizeof(unsigned int));
+	if (!(cm->counts && cm->counts[0] && cm->hasha && cm->hashb))
+	{
+		fprintf(stderr,"Out of memory error allocating %d counters\n",
+			cm->depth*cm->width);
+		exit(1);
+	}
+	memcpy(cm->counts[0],cmold->counts[0],cm->depth*cm->width*sizeof(int));
+	memcpy(cm->hasha,cmold->hasha,cm->depth*sizeof(unsigned int));
+	memcpy(cm->hashb,cmold->hashb,cm->depth*sizeof(unsigned int));
+	for (j=0;j<cm->depth;j++)
+		cm->counts[j]=cm->counts[0]+j*cm->width;
+	return cm;
+}
+
+void CM_Destroy(CM_type * cm)
+{
+	if (!cm) return;
+	free(cm->hasha);
+	free(cm->hashb);
+	free(cm->counts[0]);
+	free(cm->counts);
+	free(cm);
+}
+
+int CM_Size(CM_type * cm)
+{ // return the size of the sketch in bytes
+	int counts, hashes, admin;
+	if (!cm) return 0;
+	admin=sizeof(CM_type);
+	counts=cm->width*cm->depth*sizeof(int);
+	hashes=cm->depth*2*sizeof(unsigned int)+cm->depth*sizeof(int *);
+	return(admin + hashes + counts);
+}
+
+static inline unsigned int CM_Hash(CM_type * cm, int j, unsigned int item)
+{ // the bucket for item in row j
+	return (unsigned int) (hash31(cm->hasha[j],cm->hashb[j],item) % cm->width);
+}
+
+static void CM_HashBlock(CM_type * cm, int j, const unsigned int * items,
+						 unsigned int * buckets, int n)
+{
+	// compute the row j buckets of a block of items: hash31_batch
+	// hashes eight or sixteen at a time, and the modulus is kept out
+	// of it since integer division does not vectorize.
+	int i;
+
+	hash31_batch(cm->hasha[j],cm->hashb[j],items,buckets,n);
+	for (i=0;i<n;i++)
+		buckets[i]%=cm->width;
+}
+
+void CM_Update(CM_type * cm, unsigned int item, int diff)
+{
+	int j;
+
+	if (!cm) return;
+	cm->count+=diff;
+	for (j=0;j<cm->depth;j++)
+		cm->counts[j][CM_Hash(cm,j,item)]+=diff;
+	// this can be done more efficiently if the width is a power of two
+}
+
+void CM_UpdateConservative(CM_type * cm, unsigned int item, int diff)
+{
+	// raise each counter only as far as the new estimate requires
+	unsigned int buckets[64], *bpt;
+	int j, est;
+
+	if (!cm) return;
+	if (diff<0)
+	{ // conservative update is not valid for deletions
+		CM_Update(cm,item,diff);
+		return;
+	}
+	bpt=(cm->depth<=64) ? buckets :
+		(unsigned int *) malloc(cm->depth*sizeof(unsigned int));
+	cm->count+=diff;
+	est=INT_MAX;
+	for (j=0;j<cm->depth;j++)
+	{
+		bpt[j]=CM_Hash(cm,j,item);
+		if (cm->counts[j][bpt[j]]<est)
+			est=cm->counts[j][bpt[j]];
+	}
+	est+=diff;
+	for (j=0;j<cm->depth;j++)
+		if (cm->counts[j][bpt[j]]<est)
+			cm->counts[j][bpt[j]]=est;
+	if (bpt!=buckets) free(bpt);
+}
+
+void CM_UpdateBatch(CM_type * cm, const unsigned int * items,
+					const int * diffs, int n)
+{
+	// process the batch in blocks, one row at a time, so that the hashing
+	// runs over a whole block and each row's counters stay in cache
+	unsigned int buckets[CM_BATCH];
+	int i, j, m, off;
+	int * row;
+
+	if (!cm) return;
+	for (off=0;off<n;off+=CM_BATCH)
+	{
+		m=(n-off<CM_BATCH) ? n-off : CM_BATCH;
+		for (j=0;j<cm->depth;j++)
+		{
+			CM_HashBlock(cm,j,items+off,buckets,m);
+			row=cm->counts[j];
+			if (diffs)
+				for (i=0;i<m;i++)
+					row[buckets[i]]+=diffs[off+i];
+			else
+				for (i=0;i<m;i++)
+					row[buckets[i]]++;
+		}
+		if (diffs)
+			for (i=0;i<m;i++)
+				cm->count+=diffs[off+i];
+		else
+			cm->count+=m;
+	}
+}
+
+void CM_UpdateConservativeBatch(CM_type * cm, const unsigned int * items,
+								const int * diffs, int n)
+{
+	// the updates must be applied in order, since each one depends on the
+	// counters left by the last, but the hashing can still be done by block
+	unsigned int * buckets;
+	int i, j, m, off, est, diff;
+
+	if (!cm) return;
+	buckets=(unsigned int *) malloc(cm->depth*CM_BATCH*sizeof(unsigned int));
+	for (off=0;off<n;off+=CM_BATCH)
+	{
+		m=(n-off<CM_BATCH) ? n-off : CM_BATCH;
+		for (j=0;j<cm->depth;j++)
+			CM_HashBlock(cm,j,items+off,buckets+j*CM_BATCH,m);
+		for (i=0;i<m;i++)
+		{
+			diff=(diffs) ? diffs[off+i] : 1;
+			cm->count+=diff;
+			if (diff<0)
+			{
+				for (j=0;j<cm->depth;j++)
+					cm->counts[j][buckets[j*CM_BATCH+i]]+=diff;
+				continue;
+			}
+			est=INT_MAX;
+			for (j=0;j<cm->depth;j++)
+				if (cm->counts[j][buckets[j*CM_BATCH+i]]<est)
+					est=cm->counts[j][buckets[j*CM_BATCH+i]];
+			est+=diff;
+			for (j=0;j<cm->depth;j++)
+				if (cm->counts[j][buckets[j*CM_BATCH+i]]<est)
+					cm->counts[j][buckets[j*CM_BATCH+i]]=est;
+		}
+	}
+	free(buckets);
+}
+
+int CM_PointEst(CM_type * cm, unsigned int query)
+{
+	// return an estimate of the count of an item by taking the minimum
+	int j, ans;
+
+	if (!cm) return 0;
+	ans=cm->counts[0][CM_Hash(cm,0,query)];
+	for (j=1;j<cm->depth;j++)
+		ans=(std::min)(ans,cm->counts[j][CM_Hash(cm,j,query)]);
+	return (ans);
+}
+
+void CM_PointEstBatch(CM_type * cm, const unsigned int * queries,
+					  int * out, int n)
+{
+	// estimate a block of items at once: one pass per row, taking the
+	// running minimum in out
+	unsigned int buckets[CM_BATCH];
+	int i, j, m, off;
+	int * row;
+
+	if (!cm) return;
+	for (off=0;off<n;off+=CM_BATCH)
+	{
+		m=(n-off<CM_BATCH) ? n-off : CM_BATCH;
+		for (i=0;i<m;i++)
+			out[off+i]=INT_MAX;
+		for (j=0;j<cm->depth;j++)
+		{
+			CM_HashBlock(cm,j,queries+off,buckets,m);
+			row=cm->counts[j];
+			for (i=0;i<m;i++)
+				out[off+i]=(std::min)(out[off+i],row[buckets[i]]);
+		}
+	}
+}
+
+int CM_Compatible(CM_type * cm1, CM_type * cm2)
+{ // test whether two sketches are comparable (have same parameters)
+	int i;
+
+	if (!cm1 || !cm2) return 0;
+	if (cm1->width!=cm2->width) return 0;
+	if (cm1->depth!=cm2->depth) return 0;
+	for (i=0;i<cm1->depth;i++)
+	{
+		if (cm1->hasha[i]!=cm2->hasha[i]) return 0;
+		if (cm1->hashb[i]!=cm2->hashb[i]) return 0;
+	}
+	return 1;
+}
+
+int CM_Merge(CM_type * cm1, CM_type * cm2)
+{
+	// add the counts of cm2 into cm1; both must use the same hash functions
+	int i, total;
+
+	if (!CM_Compatible(cm1,cm2)) return 0;
+	total=cm1->depth*cm1->width;
+	for (i=0;i<total;i++)
+		cm1->counts[0][i]+=cm2->counts[0][i];
+	cm1->count+=cm2->count;
+	return 1;
+}
@@ -0,0 +1,43 @@
+// countmin.h -- header file for the Count-Min sketch
+// see Cormode & Muthukrishnan, LATIN 2004 / J. Algorithms 2005 for details
+
+#ifndef COUNTMIN_h
+#define COUNTMIN_h
+
+#include "prng.h"
+
+#define CM_BATCH 256 // number of items hashed together in the batch routines
+
+typedef struct CM_type{
+  long long count;   // total weight of updates received
+  int depth;         // number of rows (independent hash functions)
+  int width;         // number of counters in each row
+  int ** counts;     // counts[j] points into one contiguous depth*width block
+  unsigned int *hasha, *hashb; // parameters for hash31, one pair per row
+} CM_type;
+
+extern CM_type * CM_Init(int, int, int);
+// initialize with width, depth and a seed for the hash functions
+extern CM_type * CM_Copy(CM_type *);
+extern void CM_Destroy(CM_type *);
+extern int CM_Size(CM_type *); // size of the sketch in bytes
+
+extern void CM_Update(CM_type *, unsigned int, int);
+extern void CM_UpdateConservative(CM_type *, unsigned int, int);
+// conservative update: only raise the counters that define the estimate
+// (only meaningful for positive weights)
+extern void CM_UpdateBatch(CM_type *, const unsigned int *, const int *, int);
+extern void CM_UpdateConservativeBatch(CM_type *, const unsigned int *,
+                                       const int *, int);
+// batched versions: items, weights (NULL for all ones), number of items
+
+extern int CM_PointEst(CM_type *, unsigned int);
+extern void CM_PointEstBatch(CM_type *, const unsigned int *, int *, int);
+// estimate items[0..n-1] into out[0..n-1]
+
+extern int CM_Compatible(CM_type *, CM_type *);
+// true if two sketches share width, depth and hash functions
+extern int CM_Merge(CM_type *, CM_type *);
+// add the second sketch into the first; returns 0 if not compatible
+
+#endif
@@ -0,0 +1,186 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "frequent.h"
+#include "prng.h"
+/********************************************************************
+Implementation of Frequent algorithm to Find Frequent Items
+Based on papers by:
+Misra and Gries, 1982
+Demaine, Lopez-Ortiz, Munroe, 2002
+Karp, Papadimitriou and Shenker, 2003
+
+This version is aimed at small k.  There is no hash table: the items
+and counts sit in two flat arrays that are scanned eight at a time
+(with AVX2 compares when the processor has them).  The step that
+decrements every counter is not applied to the array; instead a
+global offset is raised, and a counter is free once its stored value
+is no more than the offset.
+
+This work is licensed under the Creative Commons
+Attribution-NonCommercial License. To view a copy of this license,
+visit http://creativecommons.org/licenses/by-nc/1.0/ or send a letter
+to Creative Commons, 559 Nathan Abbott Way, Stanford, California
+94305, USA.
+*********************************************************************/
+
+#define FREQ_RENORM (1<<30) // fold the offset back into the counts here
+
+F_type * F_Init(float fPhi)
+{
+	F_type * f;
+	int k;
+
+	k=(int) (1.0/fPhi);
+	if (k<1) k=1;
+	k=(k+FREQ_LANES-1)/FREQ_LANES*FREQ_LANES;
+
+	f=(F_type *) calloc(1,sizeof(F_type));
+	f->k=k;
+	f->n=0;
+	f->offset=0;
+	f->decrements=0;
+	f->mem=calloc(1,k*(sizeof(uint32_t)+sizeof(int))+32);
+	if (!f->mem)
+	{
+		fprintf(stderr,"Out of memory error allocating %d counters\n",k);
+		exit(1);
+	}
+	f->items=(uint32_t *) (((size_t) f->mem+31) & ~((size_t) 31));
+	f->counts=(int *) (f->items+k);
+	// all counts start at zero, which is <= offset: every counter is free
+	return f;
+}
+
+void F_Destroy(F_type * f)
+{
+	if (!f) return;
+	free(f->mem);
+	free(f);
+}
+
+static int F_ScanScalar(F_type * f, uint32_t item, int * freeslot)
+{
+	// return the counter holding item, or -1; also note the first free
+	// counter in case the item is not there
+	int i;
+
+	*freeslot=-1;
+	for (i=0;i<f->k;i++)
+	{
+		if (f->counts[i]>f->offset)
+		{
+			if (f->items[i]==item) return i;
+		}
+		else if (*freeslot<0) *freeslot=i;
+	}
+	return -1;
+}
+
+static inline int F_Scan(F_type * f, uint32_t item, int * freeslot)
+{
+#ifdef SCAN_AVX2
+	if (SCAN_UseAVX2())
+		return SCAN_FindAVX2(f->counts,f->items,f->k,item,f->offset,freeslot);
+#endif
+	return F_ScanScalar(f,item,freeslot);
+}
+
+static int F_Min(F_type * f)
+{
+	int i, m;
+#ifdef SCAN_AVX2
+	if (SCAN_UseAVX2()) return f->counts[SCAN_MinAVX2(f->counts,f->k)];
+#endif
+	m=INT_MAX;
+	for (i=0;i<f->k;i++)
+		if (f->counts[i]<m) m=f->counts[i];
+	return m;
+}
+
+static void F_Renormalize(F_type * f)
+{
+	// subtract the offset from every counter, so that it does not overflow
+	int i;
+
+	for (i=0;i<f->k;i++)
+		f->counts[i]=(f->counts[i]>f->offset) ? f->counts[i]-f->offset : 0;
+	f->offset=0;
+}
+
+void F_Update(F_type * f, uint32_t item, int value)
+{
+	int i, freeslot, d;
+
+	if (value<=0) return; // the algorithm is for insertions only
+	f->n+=value;
+	i=F_Scan(f,item,&freeslot);
+	if (i>=0)
+	{ // the item is monitored: just add to its count
+		f->counts[i]+=value;
+		return;
+	}
+	if (freeslot<0)
+	{
+		// every counter is in use: decrement them all (and the new item)
+		// by as much as possible, up to the weight of the new item.
+		// for unit weights the minimum is at least one, so the scan for
+		// the minimum can be skipped
+		d=(value==1) ? 1 : (std::min)(value,F_Min(f)-f->offset);
+		f->offset+=d;
+		f->decrements+=d;
+		value-=d;
+		if (value==0)
+		{
+			if (f->offset>=FREQ_RENORM) F_Renormalize(f);
+			return;
+		}
+		for (freeslot=0;f->counts[freeslot]>f->offset;freeslot++);
+		// the counter that reached zero holds what remains of the item
+	}
+	f->items[freeslot]=item;
+	f->counts[freeslot]=f->offset+value;
+	if (f->offset>=FREQ_RENORM) F_Renormalize(f);
+}
+
+int F_Size(F_type * f)
+{ // return the size of the data structure in bytes
+	return sizeof(F_type)+f->k*(sizeof(uint32_t)+sizeof(int));
+}
+
+int F_PointEst(F_type * f, uint32_t item)
+{ // a lower bound on the count of item
+	int i, freeslot;
+
+	i=F_Scan(f,item,&freeslot);
+	return (i>=0) ? f->counts[i]-f->offset : 0;
+}
+
+int F_PointErr(F_type * f, uint32_t)
+{
+	// the count of any item is at most its estimate plus this.  Every
+	// decrement takes one from all counters at once, and an item can
+	// have lost at most one per decrement, so the bound is the same for
+	// every item, monitored or not
+	return (int) f->decrements;
+}
+
+std::map<uint32_t, uint32_t> F_Output(F_type * f, int thresh)
+{
+	// items are kept by their upper bound, estimate plus error, so that
+	// none with a count of thresh or more is missed.  An item with no
+	// counter has at most decrements, which is below n/(k+1)
+	std::map<uint32_t, uint32_t> res;
+	long long up;
+	int i;
+
+	for (i=0;i<f->k;i++)
+	{
+		if (f->counts[i]<=f->offset) continue; // free
+		up=f->counts[i]-f->offset+f->decrements;
+		if (up>=thresh)
+			res.insert(std::pair<uint32_t, uint32_t>(f->items[i],
+				(uint32_t) up));
+	}
+	return res;
+}
@@ -0,0 +1,34 @@
+// frequent.h -- header file for the Frequent (Misra-Gries) algorithm
+// see Misra & Gries 1982, Demaine et al. 2002, Karp et al. 2003
+
+#ifndef FREQUENT_h
+#define FREQUENT_h
+
+#include "prng.h"
+#include "smallscan.h"
+
+#define FREQ_LANES SCAN_LANES // counters are scanned eight at a time
+
+typedef struct F_type
+{
+  int k;            // number of counters, a multiple of FREQ_LANES
+  int n;            // total weight of updates received
+  int offset;       // decrements applied lazily to every counter
+  long long decrements; // total of all decrements, the error bound
+  void *mem;        // allocation holding items and counts
+  uint32_t *items;  // item identifiers, aligned for vector loads
+  int *counts;      // counts[i]-offset is the count of items[i];
+                    // a counter is free when counts[i]<=offset
+} F_type;
+
+extern F_type * F_Init(float fPhi);
+extern void F_Destroy(F_type *);
+extern void F_Update(F_type *, uint32_t, int);
+extern int F_Size(F_type *);
+extern int F_PointEst(F_type *, uint32_t); // a lower bound on the count
+extern int F_PointErr(F_type *, uint32_t); // the most it can undercount by
+extern std::map<uint32_t, uint32_t> F_Output(F_type *, int);
+// the monitored items whose upper bound (estimate plus error) is thresh
+// or more, with that bound: no item with a count of thresh is left out
+
+#endif
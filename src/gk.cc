@@ -0,0 +1,288 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "gk4.h"
+/********************************************************************
+Implementation of the Greenwald-Khanna quantile summary
+Based on the paper of Greenwald and Khanna, 2001
+Unlike the q-digest, values need not come from a bounded integer
+domain: the summary keeps a sorted list of (value, g, delta) tuples
+and any two values that can be compared can be inserted.
+
+A new value is given the rank uncertainty of its successor, so that
+g+delta <= 2 eps n holds for every tuple, and adjacent tuples are
+merged every 1/(2 eps) insertions while the bound is respected.
+
+This work is licensed under the Creative Commons
+Attribution-NonCommercial License. To view a copy of this license,
+visit http://creativecommons.org/licenses/by-nc/1.0/ or send a letter
+to Creative Commons, 559 Nathan Abbott Way, Stanford, California
+94305, USA.
+*********************************************************************/
+
+#define GK_INITSIZE 64
+
+GK_type * GK_Init(double eps)
+{
+	GK_type * gk;
+
+	gk=(GK_type *) calloc(1,sizeof(GK_type));
+	if (eps<=0.0 || eps>=1.0) eps=0.01;
+	gk->eps=eps;
+	gk->n=0;
+	gk->count=0;
+	gk->period=(int) (1.0/(2.0*eps));
+	if (gk->period<1) gk->period=1;
+	gk->_new=gk->period;
+	gk->size=GK_INITSIZE;
+	gk->tuples=(GK_tuple *) calloc(gk->size,sizeof(GK_tuple));
+	gk->spare=NULL;
+	gk->sparesize=0;
+	if (!gk->tuples)
+	{
+		fprintf(stderr,"Out of memory error allocating %d tuples\n",gk->size);
+		exit(1);
+	}
+	return gk;
+}
+
+void GK_Destroy(GK_type * gk)
+{
+	if (!gk) return;
+	free(gk->tuples);
+	free(gk->spare);
+	free(gk);
+}
+
+static void GK_Reserve(GK_type * gk, int count)
+{ // make room for count tuples
+	if (count<=gk->size) return;
+	while (gk->size<count) gk->size*=2;
+	gk->tuples=(GK_tuple *) realloc(gk->tuples,gk->size*sizeof(GK_tuple));
+	if (!gk->tuples)
+	{
+		fprintf(stderr,"Out of memory error allocating %d tuples\n",gk->size);
+		exit(1);
+	}
+}
+
+static int GK_Find(GK_type * gk, GKvalue_t v)
+{ // return the index of the first tuple with a value greater than v
+	int lo=0, hi=gk->count, mid;
+
+	while (lo<hi)
+	{
+		mid=(lo+hi)>>1;
+		if (gk->tuples[mid].v<=v) lo=mid+1;
+		else hi=mid;
+	}
+	return lo;
+}
+
+void GK_Compress(GK_type * gk)
+{
+	// merge each tuple into its right neighbour when the combined tuple
+	// still meets the error bound.  The first and last tuples (the
+	// minimum and maximum) are always kept.  Works from right to left,
+	// writing the surviving tuples to the top of the array.
+	GKweight_t thresh;
+	GK_tuple * t;
+	int i, w;
+
+	if (gk->count<3) return;
+	thresh=(GKweight_t) (2.0*gk->eps*gk->n);
+	t=gk->tuples;
+	w=gk->count-1;
+	for (i=gk->count-2;i>=0;i--)
+	{
+		if (i>0 && t[i].g+t[w].g+t[w].delta<=thresh)
+			t[w].g+=t[i].g; // fold tuple i into its successor
+		else
+			t[--w]=t[i];
+	}
+	gk->count-=w;
+	memmove(t,t+w,gk->count*sizeof(GK_tuple));
+}
+
+void GK_Insert(GK_type * gk, GKvalue_t v)
+{
+	GK_tuple * t;
+	int pos;
+
+	pos=GK_Find(gk,v);
+	GK_Reserve(gk,gk->count+1);
+	t=gk->tuples;
+	memmove(&t[pos+1],&t[pos],(gk->count-pos)*sizeof(GK_tuple));
+	t[pos].v=v;
+	t[pos].g=1;
+	if (pos==0 || pos==gk->count)
+		t[pos].delta=0; // a new minimum or maximum has an exact rank
+	else
+		t[pos].delta=t[pos+1].g+t[pos+1].delta-1;
+	gk->count++;
+	gk->n++;
+
+	if (--gk->_new<=0)
+	{
+		GK_Compress(gk);
+		gk->_new=gk->period;
+	}
+}
+
+static int GK_cmp(const void * a, const void * b)
+{
+	GKvalue_t x=*(const GKvalue_t *) a;
+	GKvalue_t y=*(const GKvalue_t *) b;
+	if (x<y) return -1;
+	else if (x>y) return 1;
+	else return 0;
+}
+
+void GK_InsertBatch(GK_type * gk, const GKvalue_t * vals, int n)
+{
+	// sort the batch, then merge it with the existing tuples in a single
+	// pass.  Every new value between two old tuples takes its delta from
+	// the old successor, exactly as if it had been inserted on its own,
+	// so the error guarantee is the same as for repeated GK_Insert calls.
+	GKvalue_t * sorted;
+	GK_tuple * t, * out;
+	int i, j, m, last;
+
+	if (n<=0) return;
+	sorted=(GKvalue_t *) malloc(n*sizeof(GKvalue_t));
+	memcpy(sorted,vals,n*sizeof(GKvalue_t));
+	qsort(sorted,n,sizeof(GKvalue_t),GK_cmp);
+
+	if (gk->sparesize<gk->count+n)
+	{
+		free(gk->spare);
+		gk->sparesize=gk->size;
+		while (gk->sparesize<gk->count+n) gk->sparesize*=2;
+		gk->spare=(GK_tuple *) malloc(gk->sparesize*sizeof(GK_tuple));
+		if (!gk->spare)
+		{
+			fprintf(stderr,"Out of memory error allocating %d tuples\n",
+				gk->sparesize);
+			exit(1);
+		}
+	}
+	t=gk->tuples;
+	out=gk->spare;
+	last=gk->count;
+	i=0;
+	j=0;
+	m=0;
+	while (j<n)
+	{
+		if (i<last && t[i].v<=sorted[j])
+			out[m++]=t[i++];
+		else
+		{ // slot the new value in ahead of tuple i
+			out[m].v=sorted[j++];
+			out[m].g=1;
+			out[m].delta=(i==0 || i==last) ? 0 : t[i].g+t[i].delta-1;
+			m++;
+		}
+	}
+	while (i<last)
+		out[m++]=t[i++];
+	free(sorted);
+
+	// the merged list becomes the summary, and the old array the scratch
+	gk->spare=gk->tuples;
+	gk->tuples=out;
+	i=gk->size;
+	gk->size=gk->sparesize;
+	gk->sparesize=i;
+	gk->count=m;
+	gk->n+=n;
+
+	GK_Compress(gk);
+	gk->_new=gk->period;
+}
+
+GKvalue_t GK_OutputQuantile(GK_type * gk, double phi)
+{
+	// return a value whose rank is within eps n of phi n
+	double bound;
+	long long rmin;
+	int i;
+
+	if (gk->count==0) return (GKvalue_t) 0;
+	bound=phi*gk->n+gk->eps*gk->n;
+	rmin=0;
+	for (i=0;i<gk->count;i++)
+	{
+		rmin+=gk->tuples[i].g;
+		if (rmin+gk->tuples[i].delta>bound)
+			return gk->tuples[(i>0)?i-1:0].v;
+	}
+	return gk->tuples[gk->count-1].v;
+}
+
+typedef struct gk_query_t
+{
+	double phi;
+	int pos;
+} GK_query;
+
+static int GK_querycmp(const void * a, const void * b)
+{
+	const GK_query * x=(const GK_query *) a;
+	const GK_query * y=(const GK_query *) b;
+	if (x->phi<y->phi) return -1;
+	else if (x->phi>y->phi) return 1;
+	else return 0;
+}
+
+void GK_OutputQuantiles(GK_type * gk, const double * phis, int n,
+						GKvalue_t * out)
+{
+	// answer many quantile queries with one scan over the tuples:
+	// visit the queries in increasing order of phi
+	GK_query * order;
+	double bound;
+	long long rmin;
+	int i, q;
+
+	if (n<=0) return;
+	order=(GK_query *) malloc(n*sizeof(GK_query));
+	for (q=0;q<n;q++)
+	{
+		order[q].phi=phis[q];
+		order[q].pos=q;
+	}
+	qsort(order,n,sizeof(GK_query),GK_querycmp);
+
+	i=0;
+	rmin=(gk->count>0) ? gk->tuples[0].g : 0;
+	for (q=0;q<n;q++)
+	{
+		if (gk->count==0)
+		{
+			out[order[q].pos]=(GKvalue_t) 0;
+			continue;
+		}
+		bound=order[q].phi*gk->n+gk->eps*gk->n;
+		while (i<gk->count && rmin+gk->tuples[i].delta<=bound)
+		{
+			i++;
+			if (i<gk->count) rmin+=gk->tuples[i].g;
+		}
+		if (i==gk->count)
+			out[order[q].pos]=gk->tuples[gk->count-1].v;
+		else
+			out[order[q].pos]=gk->tuples[(i>0)?i-1:0].v;
+	}
+	free(order);
+}
+
+int GK_Size(GK_type * gk)
+{ // output size in bytes
+	return sizeof(GK_type)+gk->count*sizeof(GK_tuple);
+}
+
+int GK_Tuples(GK_type * gk)
+{ // return the number of tuples stored
+	return (gk)?gk->count:0;
+}
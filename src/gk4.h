@@ -0,0 +1,45 @@
+// gk4.h -- header file for the Greenwald-Khanna quantile summary
+// see Greenwald & Khanna, SIGMOD 2001 for details
+
+#ifndef GK4_h
+#define GK4_h
+
+#include "prng.h"
+
+#define GKweight_t int
+#define GKvalue_t double // values come from an unbounded, ordered domain
+
+typedef struct gk_tuple_t
+{
+  GKvalue_t v;      // value stored in the summary
+  GKweight_t g;     // rmin(v) - rmin(previous value)
+  GKweight_t delta; // rmax(v) - rmin(v)
+} GK_tuple; // 16 bytes
+
+typedef struct GK_type
+{
+  double eps;        // error parameter (does not change)
+  long long n;       // number of values inserted
+  int count;         // number of tuples in use
+  int size;          // number of tuples allocated
+  int _new;          // counts down until the next compress
+  int period;        // inserts between compressions, 1/(2 eps)
+  GK_tuple *tuples;  // tuples, sorted on v
+  GK_tuple *spare;   // scratch space for merging in a batch
+  int sparesize;
+} GK_type;
+
+extern GK_type * GK_Init(double);
+// initialize with epsilon
+extern void GK_Destroy(GK_type *);
+extern void GK_Insert(GK_type *, GKvalue_t);
+extern void GK_InsertBatch(GK_type *, const GKvalue_t *, int);
+// sort a batch of values and merge it into the summary in one pass
+extern void GK_Compress(GK_type *);
+extern GKvalue_t GK_OutputQuantile(GK_type *, double);
+extern void GK_OutputQuantiles(GK_type *, const double *, int, GKvalue_t *);
+// answer a batch of quantile queries phis[0..n-1] into out[0..n-1]
+extern int GK_Size(GK_type *);   // output size of structure (in bytes)
+extern int GK_Tuples(GK_type *); // output size of structure (in tuples)
+
+#endif
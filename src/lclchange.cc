@@ -0,0 +1,185 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include "lclchange.h"
+/********************************************************************
+Heavy changers between two adjacent windows, from LCL summaries
+
+Time is cut into windows of fixed length.  The open window and the one
+before it each have an LCL summary.  When time moves into the next
+window, the summary of the old previous window is emptied (by copying
+an empty summary over it) and becomes the new open window, so no
+memory is allocated as the stream goes on.
+
+An item held by a summary has a true count in [count-delta, count].
+An item not held has a true count in [0, least count], and the least
+count is at most fPhi times the weight of the window.  The change of an
+item is then bounded by the difference of these ranges, and every item
+whose change could reach the threshold is in one of the two summaries,
+unless the threshold is below the least counts.
+
+This work is licensed under the Creative Commons
+Attribution-NonCommercial License. To view a copy of this license,
+visit http://creativecommons.org/licenses/by-nc/1.0/ or send a letter
+to Creative Commons, 559 Nathan Abbott Way, Stanford, California
+94305, USA.
+*********************************************************************/
+
+HC_type * HC_Init(float fPhi, HCtime_t width)
+{
+	HC_type * hc;
+
+	hc=(HC_type *) calloc(1,sizeof(HC_type));
+	if (!hc)
+	{
+		fprintf(stderr,"Out of memory error allocating heavy changers\n");
+		exit(1);
+	}
+	hc->width=width;
+	hc->fresh=LCL_Init(fPhi);
+	hc->cur=LCL_Clone(hc->fresh);
+	hc->prev=LCL_Clone(hc->fresh);
+	return hc;
+}
+
+void HC_Destroy(HC_type * hc)
+{
+	if (!hc) return;
+	LCL_Destroy(hc->cur);
+	LCL_Destroy(hc->prev);
+	LCL_Destroy(hc->fresh);
+	free(hc);
+}
+
+static void HC_Reset(HC_type * hc, LCL_type * lcl)
+{ // empty a window by copying the empty summary over it
+	memcpy(lcl,hc->fresh,hc->fresh->bytes);
+	LCL_Relocate(lcl);
+}
+
+static inline long long HC_Window(HC_type * hc, HCtime_t t)
+{
+	return (long long) floor(t/hc->width);
+}
+
+static void HC_MoveTo(HC_type * hc, long long w)
+{
+	LCL_type * tmp;
+
+	if (!hc->started)
+	{
+		hc->window=w;
+		hc->started=1;
+		return;
+	}
+	if (w<=hc->window) return;
+	if (w==hc->window+1)
+	{ // the open window becomes the previous one
+		tmp=hc->prev;
+		hc->prev=hc->cur;
+		hc->cur=tmp;
+		HC_Reset(hc,hc->cur);
+	}
+	else
+	{ // a whole window went by with no updates
+		HC_Reset(hc,hc->prev);
+		HC_Reset(hc,hc->cur);
+	}
+	hc->window=w;
+}
+
+void HC_Advance(HC_type * hc, HCtime_t t)
+{
+	HC_MoveTo(hc,HC_Window(hc,t));
+}
+
+void HC_Update(HC_type * hc, LCLitem_t item, HCtime_t t, LCLweight_t value)
+{
+	HC_MoveTo(hc,HC_Window(hc,t));
+	LCL_Update(hc->cur,item,value);
+}
+
+void HC_UpdateBatch(HC_type * hc, const LCLitem_t * items,
+	const HCtime_t * times, const LCLweight_t * weights, int n)
+{
+	// updates that fall in the same window are handed to LCL_UpdateBatch
+	// in one run
+	int i, start;
+	long long w;
+
+	start=0;
+	while (start<n)
+	{
+		HC_MoveTo(hc,HC_Window(hc,times[start]));
+		for (i=start+1;i<n;i++)
+		{
+			w=HC_Window(hc,times[i]);
+			if (w>hc->window) break;
+		}
+		LCL_UpdateBatch(hc->cur,items+start,weights ? weights+start : NULL,
+			i-start);
+		start=i;
+	}
+}
+
+int HC_Size(HC_type * hc)
+{ // return the size of the data structure in bytes
+	return sizeof(HC_type)+3*LCL_Size(hc->fresh);
+}
+
+static void HC_Range(LCL_type * lcl, LCLitem_t item, LCLweight_t * est,
+	long long * lo, long long * hi)
+{ // the estimate of an item, and the range its true count is in
+	*est=LCL_PointEst(lcl,item);
+	if (*est>0)
+	{
+		*hi=*est;
+		*lo=*est-(long long) LCL_PointErr(lcl,item);
+	}
+	else
+	{
+		*hi=lcl->root->count;
+		*lo=0;
+	}
+}
+
+static bool HC_Bigger(const HCChange & a, const HCChange & b)
+{
+	long long da=llabs((long long) a.after-a.before);
+	long long db=llabs((long long) b.after-b.before);
+
+	if (da!=db) return da>db;
+	return a.item<b.item;
+}
+
+std::vector<HCChange> HC_Changes(HC_type * hc, long long thresh)
+{
+	std::vector<HCChange> res;
+	HCChange c;
+	LCL_type * lcl;
+	long long blo, bhi, alo, ahi;
+	int i, pass;
+
+	// candidates are the items of the open window, then those of the
+	// previous window that the open window does not hold
+	for (pass=0;pass<2;pass++)
+	{
+		lcl=pass ? hc->prev : hc->cur;
+		for (i=1;i<=lcl->size;i++)
+		{
+			if (lcl->counters[i].count<=0) continue; // unused
+			c.item=lcl->counters[i].item;
+			if (pass && LCL_PointEst(hc->cur,c.item)>0) continue;
+			HC_Range(hc->prev,c.item,&c.before,&blo,&bhi);
+			HC_Range(hc->cur,c.item,&c.after,&alo,&ahi);
+			c.lo=alo-bhi;
+			c.hi=ahi-blo;
+			if (c.hi>=thresh || c.lo<=-thresh)
+				res.push_back(c);
+		}
+	}
+	std::sort(res.begin(),res.end(),HC_Bigger);
+	return res;
+}
@@ -0,0 +1,49 @@
+// lclchange.h -- header file for finding heavy changers
+// items whose count moved by a lot between two adjacent windows of time,
+// each summarised by an LCL summary (see lossycount.h)
+
+#ifndef LCLCHANGE_h
+#define LCLCHANGE_h
+
+#include <vector>
+#include "lossycount.h"
+
+#define HCtime_t double
+
+typedef struct HC_type
+{
+  HCtime_t width;   // length of a window
+  long long window; // number of the open window, which holds the times
+                    // [window*width, (window+1)*width)
+  int started;      // window has been set by a first update
+  LCL_type *cur;    // the open window
+  LCL_type *prev;   // the window before it
+  LCL_type *fresh;  // an empty summary, copied over prev to reuse it
+} HC_type;
+
+typedef struct hcchange_t
+{
+  LCLitem_t item;
+  LCLweight_t before; // estimated count in the previous window
+  LCLweight_t after;  // estimated count in the open window
+  long long lo, hi;   // the true change (after-before) is in [lo, hi]
+} HCChange;
+
+extern HC_type * HC_Init(float fPhi, HCtime_t width);
+// windows of about 1/fPhi counters each
+extern void HC_Destroy(HC_type *);
+extern void HC_Update(HC_type *, LCLitem_t, HCtime_t, LCLweight_t);
+extern void HC_UpdateBatch(HC_type *, const LCLitem_t *, const HCtime_t *,
+                           const LCLweight_t *, int);
+// items, times, weights (NULL for all ones), number of items.  Times
+// should not go back by more than a window: an update older than the
+// open window is counted in it
+extern void HC_Advance(HC_type *, HCtime_t); // move on, with no update
+extern int HC_Size(HC_type *);
+extern std::vector<HCChange> HC_Changes(HC_type *, long long);
+// every item held by either window that may have changed by thresh or
+// more (hi>=thresh or lo<=-thresh), largest estimated change first.  An
+// item held by neither changed by at most the least count of the two.
+// Early in a window, its counts cover only part of it
+
+#endif
@@ -0,0 +1,249 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "lcldecay.h"
+/********************************************************************
+Implementation of Lazy Lossy Counting with exponential time decay
+Based on papers by:
+Metwally, Agrawal, El Abbadi 2005
+Cormode, Shkapenyuk, Srivastava, Xu 2009 (forward decay)
+
+Under backward decay every count would have to shrink as time passes.
+With forward decay, an update at time t is given the weight
+exp(lambda*(t-L)) for a fixed landmark L, and a count C stands for the
+decayed weight C*exp(-lambda*(T-L)) at query time T.  Since every count
+is scaled by the same factor, the order of the counts never changes
+with time, and the Space Saving summary (see lossycount.cc) works on
+these weights unchanged: an update adds to one count and sifts it down
+the heap, and nothing else is touched.
+
+The weight of a time is only computed when the time changes, so that a
+stream with many updates per tick needs no exp() per update.  The
+weights grow with t, so once lambda*(t-L) passes DLCL_RENORM the
+landmark is moved up to t and every count is scaled down to match.
+This keeps the weights well inside the range of a double, and costs one
+pass over the counters about every DLCL_RENORM/lambda time units.
+
+This work is licensed under the Creative Commons
+Attribution-NonCommercial License. To view a copy of this license,
+visit http://creativecommons.org/licenses/by-nc/1.0/ or send a letter
+to Creative Commons, 559 Nathan Abbott Way, Stanford, California
+94305, USA.
+*********************************************************************/
+
+#define DLCL_NULLITEM 0x7FFFFFFF
+
+static inline int DLCL_Hash(DLCL_type * dlcl, LCLitem_t item)
+{
+	return (int) hash31(dlcl->hasha, dlcl->hashb,item) % dlcl->hashsize;
+}
+
+DLCL_type * DLCL_Init(float fPhi, double lambda)
+{ // hash functions are picked at random: see DLCL_InitSeed
+	return DLCL_InitSeed(fPhi,lambda,LC_RandomSeed());
+}
+
+DLCL_type * DLCL_InitSeed(float fPhi, double lambda, int seed)
+{
+	DLCL_type * dlcl;
+	int i, k;
+
+	k=1+(int) (1.0/fPhi);
+	dlcl=(DLCL_type *) LC_Alloc(1,sizeof(DLCL_type));
+	dlcl->size=k;
+	dlcl->hashsize=LCL_HASHMULT*k;
+	dlcl->lambda=(lambda>0) ? lambda : 0;
+	dlcl->landmark=0;
+	dlcl->last=0;
+	dlcl->lastwt=1.0;
+	dlcl->n=0;
+	dlcl->counters=(DLCLCounter *) LC_Alloc(1+k,sizeof(DLCLCounter));
+	dlcl->hashtable=(int *) LC_Alloc(dlcl->hashsize,sizeof(int));
+	dlcl->heap=(int *) LC_Alloc(1+k,sizeof(int));
+	dlcl->heappos=(int *) LC_Alloc(1+k,sizeof(int));
+	for (i=1;i<=k;i++)
+	{
+		dlcl->counters[i].item=DLCL_NULLITEM;
+		dlcl->heap[i]=i; // all counts are zero, so any order is a heap
+		dlcl->heappos[i]=i;
+	}
+	dlcl->prng=prng_Init(-abs(seed),2);
+	dlcl->hasha=prng_int(dlcl->prng) & MOD;
+	dlcl->hashb=prng_int(dlcl->prng) & MOD;
+	return dlcl;
+}
+
+void DLCL_Destroy(DLCL_type * dlcl)
+{
+	if (!dlcl) return;
+	prng_Destroy(dlcl->prng);
+	free(dlcl->counters);
+	free(dlcl->hashtable);
+	free(dlcl->heap);
+	free(dlcl->heappos);
+	free(dlcl);
+}
+
+static void DLCL_Rehash(DLCL_type * dlcl)
+{
+	// pick new hash function parameters and rebuild the chains, when an
+	// update has walked a chain longer than LCL_MAXCHAIN
+	int i, h;
+
+	dlcl->hasha=prng_int(dlcl->prng) & MOD;
+	dlcl->hashb=prng_int(dlcl->prng) & MOD;
+	memset(dlcl->hashtable,0,dlcl->hashsize*sizeof(int));
+	for (i=1;i<=dlcl->size;i++)
+	{
+		if (dlcl->counters[i].item==DLCL_NULLITEM) continue;
+		h=DLCL_Hash(dlcl,dlcl->counters[i].item);
+		dlcl->counters[i].next=dlcl->hashtable[h];
+		dlcl->hashtable[h]=i;
+	}
+}
+
+static void DLCL_Renormalize(DLCL_type * dlcl, DLCLtime_t t)
+{
+	// move the landmark to t: every count is scaled by the same factor,
+	// so the heap and the chains stay as they are
+	double scale;
+	int i;
+
+	scale=exp(-dlcl->lambda*(t-dlcl->landmark));
+	for (i=1;i<=dlcl->size;i++)
+	{
+		dlcl->counters[i].count*=scale;
+		dlcl->counters[i].delta*=scale;
+	}
+	dlcl->n*=scale;
+	dlcl->landmark=t;
+}
+
+static inline double DLCL_Weight(DLCL_type * dlcl, DLCLtime_t t)
+{ // the forward decay weight of an update at time t
+	if (t==dlcl->last) return dlcl->lastwt;
+	if (dlcl->lambda*(t-dlcl->landmark)>DLCL_RENORM)
+		DLCL_Renormalize(dlcl,t);
+	dlcl->last=t;
+	dlcl->lastwt=exp(dlcl->lambda*(t-dlcl->landmark));
+	return dlcl->lastwt;
+}
+
+static void DLCL_Heapify(DLCL_type * dlcl, int pos)
+{ // the counter at heap position pos has grown: move it down the heap
+	DLCLCounter * counters=dlcl->counters;
+	int * heap=dlcl->heap;
+	int c, mc;
+	double count;
+
+	c=heap[pos];
+	count=counters[c].count;
+	while (2*pos<=dlcl->size)
+	{
+		mc=2*pos;
+		if (mc<dlcl->size &&
+			counters[heap[mc+1]].count<counters[heap[mc]].count)
+			mc++;
+		if (count<=counters[heap[mc]].count) break;
+		heap[pos]=heap[mc];
+		dlcl->heappos[heap[pos]]=pos;
+		pos=mc;
+	}
+	heap[pos]=c;
+	dlcl->heappos[c]=pos;
+}
+
+static int DLCL_Find(DLCL_type * dlcl, LCLitem_t item, int hashval,
+	int * chain)
+{ // the counter of item, or 0; chain is set to the number of entries seen
+	int c;
+
+	*chain=0;
+	for (c=dlcl->hashtable[hashval];c;c=dlcl->counters[c].next)
+	{
+		(*chain)++;
+		if (dlcl->counters[c].item==item) break;
+	}
+	return c;
+}
+
+void DLCL_Update(DLCL_type * dlcl, LCLitem_t item, DLCLtime_t t,
+	double value)
+{
+	DLCLCounter * root;
+	int c, hashval, chain, *pp;
+
+	value*=DLCL_Weight(dlcl,t);
+	dlcl->n+=value;
+	hashval=DLCL_Hash(dlcl,item);
+	c=DLCL_Find(dlcl,item,hashval,&chain);
+	if (!c)
+	{ // take over the counter with the least count, as in LCL_Update
+		c=dlcl->heap[1];
+		root=&dlcl->counters[c];
+		if (root->item!=DLCL_NULLITEM)
+		{ // unlink it from its chain
+			pp=&dlcl->hashtable[DLCL_Hash(dlcl,root->item)];
+			while (*pp!=c) pp=&dlcl->counters[*pp].next;
+			*pp=root->next;
+		}
+		root->item=item;
+		root->next=dlcl->hashtable[hashval];
+		dlcl->hashtable[hashval]=c;
+		root->delta=root->count;
+	}
+	dlcl->counters[c].count+=value;
+	DLCL_Heapify(dlcl,dlcl->heappos[c]);
+	if (chain>LCL_MAXCHAIN) DLCL_Rehash(dlcl);
+}
+
+int DLCL_Size(DLCL_type * dlcl)
+{ // return the size of the data structure in bytes
+	return sizeof(DLCL_type)+(dlcl->size+1)*sizeof(DLCLCounter)
+		+dlcl->hashsize*sizeof(int)+2*(dlcl->size+1)*sizeof(int);
+}
+
+static inline double DLCL_Scale(DLCL_type * dlcl, DLCLtime_t t)
+{ // turns a count into a weight as seen at time t
+	return exp(-dlcl->lambda*(t-dlcl->landmark));
+}
+
+double DLCL_PointEst(DLCL_type * dlcl, LCLitem_t item, DLCLtime_t t)
+{ // estimate the decayed weight of a particular item
+	int c, chain;
+
+	c=DLCL_Find(dlcl,item,DLCL_Hash(dlcl,item),&chain);
+	return (c) ? dlcl->counters[c].count*DLCL_Scale(dlcl,t) : 0;
+}
+
+double DLCL_PointErr(DLCL_type * dlcl, LCLitem_t item, DLCLtime_t t)
+{ // the worst case error in the estimate of a particular item
+	int c, chain;
+
+	c=DLCL_Find(dlcl,item,DLCL_Hash(dlcl,item),&chain);
+	if (!c) c=dlcl->heap[1];
+	return dlcl->counters[c].delta*DLCL_Scale(dlcl,t);
+}
+
+double DLCL_Total(DLCL_type * dlcl, DLCLtime_t t)
+{
+	return dlcl->n*DLCL_Scale(dlcl,t);
+}
+
+std::map<uint32_t, double> DLCL_Output(DLCL_type * dlcl, double thresh,
+	DLCLtime_t t)
+{
+	std::map<uint32_t, double> res;
+	double scale=DLCL_Scale(dlcl,t);
+	int i;
+
+	for (i=1;i<=dlcl->size;++i)
+	{
+		if (dlcl->counters[i].item!=DLCL_NULLITEM &&
+			dlcl->counters[i].count*scale>=thresh)
+			res.insert(std::pair<uint32_t, double>(dlcl->counters[i].item,
+				dlcl->counters[i].count*scale));
+	}
+	return res;
+}
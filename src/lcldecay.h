@@ -0,0 +1,55 @@
+// lcldecay.h -- header file for exponentially decayed Lossy Counting
+// a Space Saving summary (see lossycount.h) of forward decayed weights,
+// see Cormode, Shkapenyuk, Srivastava, Xu, ICDE 2009 for forward decay
+
+#ifndef LCLDECAY_h
+#define LCLDECAY_h
+
+#include "lossycount.h"
+
+#define DLCLtime_t double
+#define DLCL_RENORM 256.0 // move the landmark up once lambda*(t-landmark)
+  // exceeds this, so that weights stay well inside the range of a double
+
+typedef struct dlclcounter_t
+{
+  LCLitem_t item; // item identifier
+  int next;       // next counter in the same hash chain, 0 at the end
+  double count;   // (upper bound on) weight of the item, as of the landmark
+  double delta;   // max possible error in count
+} DLCLCounter; // 24 bytes
+
+typedef struct DLCL_type
+{
+  int size, hashsize;
+  int hasha, hashb;
+  double lambda;       // decay rate: weight halves every ln(2)/lambda
+  DLCLtime_t landmark; // an update at time t weighs exp(lambda*(t-landmark))
+  DLCLtime_t last;     // time of the last update, and
+  double lastwt;       // its weight, reused while time stands still
+  double n;            // total weight, as of the landmark
+  DLCLCounter *counters; // index from 1; counter 0 is not used
+  int *hashtable;      // first counter of each hash chain, 0 if empty
+  int *heap;           // heap[1..size] are counters, least count first
+  int *heappos;        // heappos[c] is the position of counter c in heap
+  prng_type *prng;     // source of the hash parameters, also for rehashing
+} DLCL_type;
+
+extern DLCL_type * DLCL_Init(float fPhi, double lambda); // random seed
+extern DLCL_type * DLCL_InitSeed(float fPhi, double lambda, int seed);
+// about 1/fPhi counters.  Weights decay as exp(-lambda*age); lambda<=0
+// gives no decay at all
+extern void DLCL_Destroy(DLCL_type *);
+extern void DLCL_Update(DLCL_type *, LCLitem_t, DLCLtime_t, double);
+// item, time of the update, and its weight.  Times need not be in order
+extern int DLCL_Size(DLCL_type *);
+extern double DLCL_PointEst(DLCL_type *, LCLitem_t, DLCLtime_t);
+extern double DLCL_PointErr(DLCL_type *, LCLitem_t, DLCLtime_t);
+extern double DLCL_Total(DLCL_type *, DLCLtime_t);
+// decayed weight of an item, bound on its error, and decayed weight of
+// all updates, as seen at the given time
+extern std::map<uint32_t, double> DLCL_Output(DLCL_type *, double,
+                                              DLCLtime_t);
+// every item whose decayed weight at the given time is thresh or more
+
+#endif
@@ -0,0 +1,283 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <unordered_map>
+#include "lclhhh.h"
+/********************************************************************
+Hierarchical heavy hitters over prefixes, from one LCL summary per
+prefix length
+Based on papers by:
+Cormode, Korn, Muthukrishnan, Srivastava 2003
+Ben Basat, Einziger, Friedman, Luizelli, Waisbard 2017 (RHHH)
+
+Each level keeps an LCL summary of the prefixes of one length, such as
+/8, /16, /24 and /32 for IPv4 sources.  Updated in full, an update masks
+the item and updates every level.  Sampled, as in RHHH, it updates one
+level only, picked at random, and a count there stands for levels times
+its weight.  That is one LCL update per item whatever the number of
+levels; the price is a sampling error of about sqrt(levels*n), which
+is small next to fPhi*n once the stream is long.  HHH_UpdateBatch
+gathers the masked items of a block per level, and hands each level's
+run to LCL_UpdateBatch, which prefetches the buckets.
+
+The output goes from the longest prefixes to the shortest.  A prefix
+is reported if its weight, less that of its closest reported
+descendants, is at least the threshold.  The weight of the prefix is
+taken as an upper bound, and that of the descendants as a lower bound.
+So every prefix that is not reported has less than the threshold under
+it, once what is under its closest reported descendants is taken out.
+
+This work is licensed under the Creative Commons
+Attribution-NonCommercial License. To view a copy of this license,
+visit http://creativecommons.org/licenses/by-nc/1.0/ or send a letter
+to Creative Commons, 559 Nathan Abbott Way, Stanford, California
+94305, USA.
+*********************************************************************/
+
+HHH_type * HHH_Init(float fPhi, int levels, const int * bits, int sampled)
+{ // hash functions and levels are picked at random: see HHH_InitSeed
+	return HHH_InitSeed(fPhi,levels,bits,sampled,LC_RandomSeed());
+}
+
+HHH_type * HHH_InitSeed(float fPhi, int levels, const int * bits,
+	int sampled, int seed)
+{
+	HHH_type * hhh;
+	uint64_t z;
+	int i, j, b;
+
+	hhh=(HHH_type *) LC_Alloc(1,sizeof(HHH_type));
+	// keep each length once, longest first
+	for (i=0;i<levels;i++)
+	{
+		b=bits[i];
+		if (b<0) b=0;
+		if (b>32) b=32;
+		for (j=0;j<hhh->levels && hhh->bits[j]>b;j++);
+		if (j<hhh->levels && hhh->bits[j]==b) continue;
+		memmove(&hhh->bits[j+1],&hhh->bits[j],(hhh->levels-j)*sizeof(int));
+		hhh->bits[j]=b;
+		hhh->levels++;
+	}
+	if (hhh->levels==0)
+		hhh->bits[hhh->levels++]=32;
+	for (i=0;i<hhh->levels;i++)
+	{
+		hhh->mask[i]=(hhh->bits[i]==0) ? 0 : 0xFFFFFFFFu<<(32-hhh->bits[i]);
+		hhh->lcl[i]=LCL_InitSeed(fPhi,seed+i);
+	}
+	hhh->sampled=(sampled && hhh->levels>1);
+	z=(uint64_t) seed*0x9E3779B97F4A7C15ull; // splitmix64, to spread the seed
+	z=(z^(z>>30))*0xBF58476D1CE4E5B9ull;
+	z=(z^(z>>27))*0x94D049BB133111EBull;
+	hhh->rnd=(z^(z>>31)) | 1;
+	hhh->buf=(LCLitem_t *) LC_Alloc(hhh->levels*LCL_BATCH,sizeof(LCLitem_t));
+	hhh->wbuf=(LCLweight_t *) LC_Alloc(hhh->levels*LCL_BATCH,
+		sizeof(LCLweight_t));
+	return hhh;
+}
+
+void HHH_Destroy(HHH_type * hhh)
+{
+	int i;
+
+	if (!hhh) return;
+	for (i=0;i<hhh->levels;i++)
+		LCL_Destroy(hhh->lcl[i]);
+	free(hhh->buf);
+	free(hhh->wbuf);
+	free(hhh);
+}
+
+static inline int HHH_Level(HHH_type * hhh)
+{ // a level picked at random, with xorshift64*
+	uint64_t r;
+
+	hhh->rnd^=hhh->rnd>>12;
+	hhh->rnd^=hhh->rnd<<25;
+	hhh->rnd^=hhh->rnd>>27;
+	r=(hhh->rnd*0x2545F4914F6CDD1Dull)>>32;
+	return (int) ((r*hhh->levels)>>32);
+}
+
+void HHH_Update(HHH_type * hhh, LCLitem_t item, LCLweight_t value)
+{
+	int i;
+
+	hhh->n+=value;
+	if (hhh->sampled)
+	{
+		i=HHH_Level(hhh);
+		LCL_Update(hhh->lcl[i],item & hhh->mask[i],value);
+		return;
+	}
+	for (i=0;i<hhh->levels;i++)
+		LCL_Update(hhh->lcl[i],item & hhh->mask[i],value);
+}
+
+void HHH_UpdateBatch(HHH_type * hhh, const LCLitem_t * items,
+	const LCLweight_t * weights, int n)
+{
+	int fill[HHH_MAXLEVELS];
+	LCLitem_t * buf;
+	LCLweight_t * wbuf;
+	int i, j, l, m, off;
+
+	for (off=0;off<n;off+=LCL_BATCH)
+	{
+		m=(n-off<LCL_BATCH) ? n-off : LCL_BATCH;
+		if (weights)
+			for (i=0;i<m;i++)
+				hhh->n+=weights[off+i];
+		else
+			hhh->n+=m;
+		if (!hhh->sampled)
+		{ // every level sees the whole block
+			buf=hhh->buf;
+			for (l=0;l<hhh->levels;l++)
+			{
+				for (i=0;i<m;i++)
+					buf[i]=items[off+i] & hhh->mask[l];
+				LCL_UpdateBatch(hhh->lcl[l],buf,weights ? weights+off : NULL,m);
+			}
+			continue;
+		}
+		for (l=0;l<hhh->levels;l++)
+			fill[l]=0;
+		for (i=0;i<m;i++)
+		{
+			l=HHH_Level(hhh);
+			j=l*LCL_BATCH+fill[l]++;
+			hhh->buf[j]=items[off+i] & hhh->mask[l];
+			if (weights) hhh->wbuf[j]=weights[off+i];
+		}
+		for (l=0;l<hhh->levels;l++)
+		{
+			if (fill[l]==0) continue;
+			buf=hhh->buf+l*LCL_BATCH;
+			wbuf=weights ? hhh->wbuf+l*LCL_BATCH : NULL;
+			LCL_UpdateBatch(hhh->lcl[l],buf,wbuf,fill[l]);
+		}
+	}
+}
+
+int HHH_Size(HHH_type * hhh)
+{ // return the size of the data structure in bytes
+	int i, size;
+
+	size=sizeof(HHH_type)+
+		hhh->levels*LCL_BATCH*(sizeof(LCLitem_t)+sizeof(LCLweight_t));
+	for (i=0;i<hhh->levels;i++)
+		size+=LCL_Size(hhh->lcl[i]);
+	return size;
+}
+
+long long HHH_Total(HHH_type * hhh)
+{
+	return hhh->n;
+}
+
+static inline long long HHH_Scale(HHH_type * hhh)
+{ // what a count in a level stands for
+	return hhh->sampled ? hhh->levels : 1;
+}
+
+static inline long long HHH_Noise(HHH_type * hhh)
+{ // allowance for the sampling error, which is 0 when not sampled
+	if (!hhh->sampled) return 0;
+	return (long long) ceil(HHH_Z*sqrt((double) hhh->levels*hhh->n));
+}
+
+static int HHH_Find(HHH_type * hhh, int bits)
+{
+	int i;
+
+	for (i=0;i<hhh->levels;i++)
+		if (hhh->bits[i]==bits) return i;
+	return -1;
+}
+
+long long HHH_PointEst(HHH_type * hhh, LCLitem_t prefix, int bits)
+{ // estimate the weight under a prefix
+	int l;
+
+	l=HHH_Find(hhh,bits);
+	if (l<0) return -1;
+	return HHH_Scale(hhh)*LCL_PointEst(hhh->lcl[l],prefix & hhh->mask[l]);
+}
+
+long long HHH_PointErr(HHH_type * hhh, LCLitem_t prefix, int bits)
+{
+	// the worst case error in the estimate of a prefix: the delta of its
+	// counter, or the least count if it has none
+	LCL_type * lcl;
+	long long err;
+	int l;
+
+	l=HHH_Find(hhh,bits);
+	if (l<0) return -1;
+	lcl=hhh->lcl[l];
+	prefix&=hhh->mask[l];
+	if (LCL_PointEst(lcl,prefix)>0)
+		err=LCL_PointErr(lcl,prefix);
+	else
+		err=lcl->root->count;
+	return HHH_Scale(hhh)*err+HHH_Noise(hhh);
+}
+
+static bool HHH_Heavier(const HHHPrefix & a, const HHHPrefix & b)
+{
+	if (a.count!=b.count) return a.count>b.count;
+	return a.prefix<b.prefix;
+}
+
+std::vector<HHHPrefix> HHH_Output(HHH_type * hhh, long long thresh)
+{
+	// below[p] is the least weight under the reported prefixes that are
+	// closest to p from below; held[q] is the same for the prefixes of
+	// the level just done, counting q itself if it was reported
+	std::unordered_map<LCLitem_t, long long> below, held;
+	std::unordered_map<LCLitem_t, long long>::iterator b;
+	std::vector<HHHPrefix> res;
+	HHHPrefix h;
+	LCL_type * lcl;
+	LCLCounter * c;
+	long long scale, noise, lo;
+	size_t first;
+	int i, l;
+
+	scale=HHH_Scale(hhh);
+	noise=HHH_Noise(hhh);
+	for (l=0;l<hhh->levels;l++)
+	{
+		first=res.size();
+		below.clear();
+		for (b=held.begin();b!=held.end();++b)
+			below[b->first & hhh->mask[l]]+=b->second;
+		held=below;
+		lcl=hhh->lcl[l];
+		for (i=1;i<=lcl->size;i++)
+		{
+			c=&lcl->counters[i];
+			if (c->count<=0) continue; // unused
+			h.prefix=c->item;
+			h.bits=hhh->bits[l];
+			h.count=scale*c->count;
+			h.cond=h.count+noise;
+			b=below.find(h.prefix);
+			if (b!=below.end())
+				h.cond-=b->second;
+			if (h.cond<thresh) continue;
+			res.push_back(h);
+			// the weight under it is at least its own lower bound, and at
+			// least that under its reported descendants
+			lo=scale*(c->count-c->delta)-noise;
+			if (b!=below.end() && b->second>lo) lo=b->second;
+			held[h.prefix]=(lo>0) ? lo : 0;
+		}
+		std::sort(res.begin()+first,res.end(),HHH_Heavier);
+	}
+	return res;
+}
@@ -0,0 +1,64 @@
+// lclhhh.h -- header file for hierarchical heavy hitters
+// heavy prefixes of 32 bit items (such as IPv4 addresses) at several
+// prefix lengths, from one LCL summary per length (see lossycount.h)
+
+#ifndef LCLHHH_h
+#define LCLHHH_h
+
+#include <vector>
+#include "lossycount.h"
+
+#define HHH_MAXLEVELS 33 // prefix lengths 0 to 32
+#define HHH_Z 2.0 // standard deviations of sampling error allowed for,
+                  // when each update goes to one level only
+
+typedef struct HHH_type
+{
+  int levels;
+  int bits[HHH_MAXLEVELS];      // prefix length of each level, longest first
+  uint32_t mask[HHH_MAXLEVELS]; // and the mask that keeps it
+  LCL_type * lcl[HHH_MAXLEVELS];
+  int sampled;      // each update goes to one level, picked at random,
+                    // and counts there for levels times its weight
+  uint64_t rnd;     // state of the generator that picks the levels
+  long long n;      // total weight
+  LCLitem_t * buf;  // LCL_BATCH items and weights per level, gathered
+  LCLweight_t * wbuf; // by HHH_UpdateBatch
+} HHH_type;
+
+typedef struct hhhprefix_t
+{
+  LCLitem_t prefix; // the item with all but the top bits cleared
+  int bits;         // prefix length
+  long long count;  // estimated weight of the items under the prefix
+  long long cond;   // at most this much of it is not under heavy prefixes
+                    // that are longer
+} HHHPrefix;
+
+extern HHH_type * HHH_Init(float fPhi, int levels, const int * bits,
+                           int sampled); // with a random seed
+extern HHH_type * HHH_InitSeed(float fPhi, int levels, const int * bits,
+                               int sampled, int seed);
+// prefix lengths bits[0..levels-1], in any order, such as {8,16,24,32}.
+// Each level has an LCL summary of about 1/fPhi counters.  Sampled, an
+// update costs one LCL update instead of levels, and estimates also
+// carry a sampling error of about sqrt(levels*n)
+extern void HHH_Destroy(HHH_type *);
+extern void HHH_Update(HHH_type *, LCLitem_t, LCLweight_t);
+extern void HHH_UpdateBatch(HHH_type *, const LCLitem_t *,
+                            const LCLweight_t *, int);
+// items, weights (NULL for all ones), number of items
+extern int HHH_Size(HHH_type *);
+extern long long HHH_Total(HHH_type *);
+extern long long HHH_PointEst(HHH_type *, LCLitem_t, int);
+extern long long HHH_PointErr(HHH_type *, LCLitem_t, int);
+// the weight under a prefix of one of the lengths (-1 for others), and
+// the worst case error of the estimate (with high probability, sampled)
+extern std::vector<HHHPrefix> HHH_Output(HHH_type *, long long);
+// the hierarchical heavy hitters: prefixes whose weight is thresh or
+// more once the weight of their heavy descendants is taken out, longest
+// prefixes first (heaviest first within a length).  Any prefix not
+// reported has less than thresh under it, besides what is under its
+// closest reported descendants
+
+#endif
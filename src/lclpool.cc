@@ -0,0 +1,328 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "lclpool.h"
+/********************************************************************
+Implementation of a pool of Lazy Lossy Counting summaries, one per group
+Based on papers by:
+Manku and Motwani, 2002
+Metwally, Agrawal, El Abbadi 2005
+
+Keeping one LCL_type per group costs three allocations and a heap and
+hash table sized for large k, per group.  Here every summary has the
+same small k, so the summaries are flat arrays of counts, items and
+deltas, scanned eight at a time (as in frequent.cc), laid end to end
+in one slab.  A group id is mapped to its summary by an open
+addressing table.  Both the slab and the table double when they fill,
+so that adding a group allocates nothing in the common case.
+
+This work is licensed under the Creative Commons
+Attribution-NonCommercial License. To view a copy of this license,
+visit http://creativecommons.org/licenses/by-nc/1.0/ or send a letter
+to Creative Commons, 559 Nathan Abbott Way, Stanford, California
+94305, USA.
+*********************************************************************/
+
+#define LCLP_HASHMULT 0x9E3779B97F4A7C15ULL // spreads group ids over the map
+
+#ifdef __GNUC__
+#define LCLP_PREFETCHADDR(p) __builtin_prefetch(p)
+#else
+#define LCLP_PREFETCHADDR(p) do {} while (0)
+#endif
+
+static inline LCLweight_t * LCLP_Counts(LCLP_type * lclp, int s)
+{
+	return (LCLweight_t *) (lclp->slab+(size_t) s*lclp->slotsize);
+}
+
+static inline LCLitem_t * LCLP_Items(LCLP_type * lclp, int s)
+{
+	return (LCLitem_t *) (LCLP_Counts(lclp,s)+lclp->k);
+}
+
+static inline LCLweight_t * LCLP_Deltas(LCLP_type * lclp, int s)
+{
+	return LCLP_Counts(lclp,s)+2*lclp->k;
+}
+
+static inline unsigned LCLP_Hash(LCLP_type * lclp, uint64_t group)
+{
+	return (unsigned) ((group*LCLP_HASHMULT)>>(64-lclp->mapbits));
+}
+
+static void LCLP_Remap(LCLP_type * lclp, int mapbits)
+{
+	// make a map with 2^mapbits entries and put every group back in it
+	int s;
+	unsigned h, mask;
+
+	free(lclp->keys);
+	free(lclp->slots);
+	lclp->mapbits=mapbits;
+	lclp->keys=(uint64_t *) LC_Alloc((size_t) 1<<mapbits,sizeof(uint64_t));
+	lclp->slots=(int *) LC_Alloc((size_t) 1<<mapbits,sizeof(int));
+	memset(lclp->slots,0xFF,((size_t) 1<<mapbits)*sizeof(int));
+	mask=(1u<<mapbits)-1;
+	for (s=0;s<lclp->groups;s++)
+	{
+		for (h=LCLP_Hash(lclp,lclp->ids[s]);lclp->slots[h]>=0;h=(h+1)&mask);
+		lclp->keys[h]=lclp->ids[s];
+		lclp->slots[h]=s;
+	}
+}
+
+static void LCLP_Grow(LCLP_type * lclp)
+{
+	// double the room for summaries; the slab is copied, but summaries
+	// keep their numbers, so the map stays valid
+	char * slab;
+	long long * totals;
+	uint64_t * ids;
+	long long maxgroups=2*lclp->maxgroups;
+
+	slab=(char *) LC_Alloc(maxgroups,lclp->slotsize);
+	totals=(long long *) LC_Alloc(maxgroups,sizeof(long long));
+	ids=(uint64_t *) LC_Alloc(maxgroups,sizeof(uint64_t));
+	memcpy(slab,lclp->slab,(size_t) lclp->groups*lclp->slotsize);
+	memcpy(totals,lclp->totals,lclp->groups*sizeof(long long));
+	memcpy(ids,lclp->ids,lclp->groups*sizeof(uint64_t));
+	free(lclp->slab);
+	free(lclp->totals);
+	free(lclp->ids);
+	lclp->slab=slab;
+	lclp->totals=totals;
+	lclp->ids=ids;
+	lclp->maxgroups=maxgroups;
+}
+
+LCLP_type * LCLP_Init(float fPhi, int groups)
+{
+	LCLP_type * lclp;
+	int k, mapbits;
+
+	k=1+(int) (1.0/fPhi);
+	k=(k+LCLP_LANES-1)/LCLP_LANES*LCLP_LANES;
+	if (groups<1) groups=1;
+
+	lclp=(LCLP_type *) calloc(1,sizeof(LCLP_type));
+	if (!lclp)
+	{
+		fprintf(stderr,"Out of memory error allocating a pool\n");
+		exit(1);
+	}
+	lclp->k=k;
+	lclp->slotsize=3*k*sizeof(LCLweight_t); // a multiple of 32 bytes
+	lclp->maxgroups=groups;
+	lclp->slab=(char *) LC_Alloc(groups,lclp->slotsize);
+	lclp->totals=(long long *) LC_Alloc(groups,sizeof(long long));
+	lclp->ids=(uint64_t *) LC_Alloc(groups,sizeof(uint64_t));
+	for (mapbits=4;(1<<mapbits)<2*groups;mapbits++);
+	LCLP_Remap(lclp,mapbits);
+	return lclp;
+}
+
+void LCLP_Destroy(LCLP_type * lclp)
+{
+	if (!lclp) return;
+	free(lclp->slab);
+	free(lclp->totals);
+	free(lclp->ids);
+	free(lclp->keys);
+	free(lclp->slots);
+	free(lclp);
+}
+
+static inline int LCLP_Find(LCLP_type * lclp, uint64_t group)
+{ // the summary of group, or -1
+	unsigned h, mask=(1u<<lclp->mapbits)-1;
+
+	for (h=LCLP_Hash(lclp,group);lclp->slots[h]>=0;h=(h+1)&mask)
+		if (lclp->keys[h]==group) return lclp->slots[h];
+	return -1;
+}
+
+static int LCLP_Slot(LCLP_type * lclp, uint64_t group)
+{ // the summary of group, which is added if it is new
+	unsigned h, mask=(1u<<lclp->mapbits)-1;
+	int s;
+
+	for (h=LCLP_Hash(lclp,group);lclp->slots[h]>=0;h=(h+1)&mask)
+		if (lclp->keys[h]==group) return lclp->slots[h];
+	if (lclp->groups==lclp->maxgroups) LCLP_Grow(lclp);
+	s=(int) lclp->groups++;
+	lclp->ids[s]=group;
+	if (2*lclp->groups>(1ll<<lclp->mapbits))
+		LCLP_Remap(lclp,lclp->mapbits+1); // keep the map half empty
+	else
+	{
+		lclp->keys[h]=group;
+		lclp->slots[h]=s;
+	}
+	return s;
+}
+
+static int LCLP_ScanScalar(const LCLweight_t * counts, const LCLitem_t * items,
+	int k, LCLitem_t item)
+{ // the counter holding item, or -1
+	int i;
+
+	for (i=0;i<k;i++)
+		if (counts[i]>0 && items[i]==item) return i;
+	return -1;
+}
+
+static int LCLP_MinScalar(const LCLweight_t * counts, int k)
+{ // the first counter with the smallest count
+	int i, best=0;
+
+	for (i=1;i<k;i++)
+		if (counts[i]<counts[best]) best=i;
+	return best;
+}
+
+static inline int LCLP_Scan(LCLP_type * lclp, int s, LCLitem_t item)
+{
+#ifdef SCAN_AVX2
+	if (SCAN_UseAVX2())
+		return SCAN_FindAVX2(LCLP_Counts(lclp,s),LCLP_Items(lclp,s),lclp->k,
+			item,0,NULL);
+#endif
+	return LCLP_ScanScalar(LCLP_Counts(lclp,s),LCLP_Items(lclp,s),lclp->k,item);
+}
+
+static inline int LCLP_Min(LCLP_type * lclp, int s)
+{
+#ifdef SCAN_AVX2
+	if (SCAN_UseAVX2()) return SCAN_MinAVX2(LCLP_Counts(lclp,s),lclp->k);
+#endif
+	return LCLP_MinScalar(LCLP_Counts(lclp,s),lclp->k);
+}
+
+static inline void LCLP_UpdateSlot(LCLP_type * lclp, int s, LCLitem_t item,
+	LCLweight_t value)
+{
+	LCLweight_t * counts=LCLP_Counts(lclp,s);
+	int i;
+
+	lclp->totals[s]+=value;
+	i=LCLP_Scan(lclp,s,item);
+	if (i<0)
+	{ // not monitored: take over the smallest counter, whose count is the
+		// most that item could have had so far (unused counters count 0)
+		i=LCLP_Min(lclp,s);
+		LCLP_Items(lclp,s)[i]=item;
+		LCLP_Deltas(lclp,s)[i]=counts[i];
+	}
+	counts[i]+=value;
+}
+
+void LCLP_Update(LCLP_type * lclp, uint64_t group, LCLitem_t item,
+	LCLweight_t value)
+{
+	LCLP_UpdateSlot(lclp,LCLP_Slot(lclp,group),item,value);
+}
+
+void LCLP_UpdateBatch(LCLP_type * lclp, const uint64_t * groups,
+	const LCLitem_t * items, const LCLweight_t * weights, int n)
+{
+	// the same as LCLP_Update on each triple in turn.  The groups of a
+	// block are looked up first, then the summaries are updated while
+	// those LCLP_PREFETCH updates ahead are fetched, so that the misses
+	// on a slab much larger than cache overlap
+	int slot[LCLP_BATCH];
+	int i, j, m, line;
+
+	for (i=0;i<n;i+=LCLP_BATCH)
+	{
+		m=(n-i<LCLP_BATCH) ? n-i : LCLP_BATCH;
+		for (j=0;j<m;j++)
+			slot[j]=LCLP_Slot(lclp,groups[i+j]);
+		for (j=0;j<m;j++)
+		{
+			if (j+LCLP_PREFETCH<m)
+				for (line=0;line<lclp->slotsize;line+=64)
+					LCLP_PREFETCHADDR(lclp->slab+
+						(size_t) slot[j+LCLP_PREFETCH]*lclp->slotsize+line);
+			LCLP_UpdateSlot(lclp,slot[j],items[i+j],weights ? weights[i+j] : 1);
+		}
+	}
+}
+
+size_t LCLP_Size(LCLP_type * lclp)
+{ // return the size of the data structure in bytes
+	return sizeof(LCLP_type)+
+		(size_t) lclp->maxgroups*(lclp->slotsize+sizeof(long long)+
+			sizeof(uint64_t))+
+		((size_t) 1<<lclp->mapbits)*(sizeof(uint64_t)+sizeof(int));
+}
+
+LCLweight_t LCLP_PointEst(LCLP_type * lclp, uint64_t group, LCLitem_t item)
+{ // estimate the count of an item in a group
+	int s, i;
+
+	s=LCLP_Find(lclp,group);
+	if (s<0) return 0;
+	i=LCLP_Scan(lclp,s,item);
+	return (i>=0) ? LCLP_Counts(lclp,s)[i] : 0;
+}
+
+LCLweight_t LCLP_PointErr(LCLP_type * lclp, uint64_t group, LCLitem_t item)
+{ // the worst case error in the estimate of an item in a group
+	int s, i;
+
+	s=LCLP_Find(lclp,group);
+	if (s<0) return 0;
+	i=LCLP_Scan(lclp,s,item);
+	return (i>=0) ? LCLP_Deltas(lclp,s)[i] :
+		LCLP_Counts(lclp,s)[LCLP_Min(lclp,s)];
+}
+
+long long LCLP_Total(LCLP_type * lclp, uint64_t group)
+{ // the total weight of updates to a group
+	int s=LCLP_Find(lclp,group);
+	return (s>=0) ? lclp->totals[s] : 0;
+}
+
+std::map<uint32_t, uint32_t> LCLP_Output(LCLP_type * lclp, uint64_t group,
+	int thresh)
+{
+	std::map<uint32_t, uint32_t> res;
+	LCLweight_t * counts;
+	LCLitem_t * items;
+	int s, i;
+
+	s=LCLP_Find(lclp,group);
+	if (s<0) return res;
+	counts=LCLP_Counts(lclp,s);
+	items=LCLP_Items(lclp,s);
+	for (i=0;i<lclp->k;i++)
+		if (counts[i]>0 && counts[i]>=thresh)
+			res.insert(std::pair<uint32_t, uint32_t>(items[i],counts[i]));
+	return res;
+}
+
+std::vector<LCLPItem> LCLP_OutputAll(LCLP_type * lclp, int thresh)
+{
+	// one pass over the slab, in summary order
+	std::vector<LCLPItem> res;
+	LCLPItem r;
+	LCLweight_t * counts;
+	LCLitem_t * items;
+	int s, i;
+
+	for (s=0;s<lclp->groups;s++)
+	{
+		counts=LCLP_Counts(lclp,s);
+		items=LCLP_Items(lclp,s);
+		for (i=0;i<lclp->k;i++)
+			if (counts[i]>0 && counts[i]>=thresh)
+			{
+				r.group=lclp->ids[s];
+				r.item=items[i];
+				r.count=counts[i];
+				res.push_back(r);
+			}
+	}
+	return res;
+}
@@ -0,0 +1,53 @@
+// lclpool.h -- header file for a pool of many small Lossy Counting summaries
+// one Space Saving summary (see lossycount.h) per group id, all of the
+// same size, kept in a single slab
+
+#ifndef LCLPOOL_h
+#define LCLPOOL_h
+
+#include <vector>
+#include "lossycount.h"
+#include "smallscan.h"
+
+#define LCLP_LANES SCAN_LANES // counters are scanned eight at a time
+#define LCLP_BATCH 256 // updates looked up together by LCLP_UpdateBatch
+#define LCLP_PREFETCH 4 // how many updates ahead LCLP_UpdateBatch fetches
+
+typedef struct LCLP_type
+{
+  int k;           // counters per summary, a multiple of LCLP_LANES
+  int slotsize;    // bytes per summary in the slab
+  long long groups;    // summaries in use
+  long long maxgroups; // summaries the slab has room for
+  char *slab;      // summary s is at slab+s*slotsize: counts[k], then
+                   // items[k], then deltas[k]; a counter is unused
+                   // while its count is 0
+  long long *totals; // total weight of the updates to each summary
+  uint64_t *ids;   // the group id of each summary
+  int mapbits;     // the map from group ids to summaries has
+  uint64_t *keys;  // 2^mapbits entries, with open addressing:
+  int *slots;      // slots[h] is the summary of group keys[h], or -1
+} LCLP_type;
+
+typedef struct lclpitem_t
+{
+  uint64_t group;
+  LCLitem_t item;
+  LCLweight_t count;
+} LCLPItem;
+
+extern LCLP_type * LCLP_Init(float fPhi, int groups);
+// summaries of about 1/fPhi counters, with room for groups to start with
+extern void LCLP_Destroy(LCLP_type *);
+extern void LCLP_Update(LCLP_type *, uint64_t, LCLitem_t, LCLweight_t);
+extern void LCLP_UpdateBatch(LCLP_type *, const uint64_t *, const LCLitem_t *,
+	const LCLweight_t *, int); // weights may be NULL
+extern size_t LCLP_Size(LCLP_type *); // more than INT_MAX for large pools
+extern LCLweight_t LCLP_PointEst(LCLP_type *, uint64_t, LCLitem_t);
+extern LCLweight_t LCLP_PointErr(LCLP_type *, uint64_t, LCLitem_t);
+extern long long LCLP_Total(LCLP_type *, uint64_t);
+extern std::map<uint32_t, uint32_t> LCLP_Output(LCLP_type *, uint64_t, int);
+extern std::vector<LCLPItem> LCLP_OutputAll(LCLP_type *, int);
+// every (group, item, count) with count>=thresh, grouped by summary
+
+#endif
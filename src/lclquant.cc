@@ -0,0 +1,223 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "lclquant.h"
+/********************************************************************
+Heavy keys with the quantiles of a value, such as the hottest URLs with
+their latencies
+
+Keys go to an LCL summary.  Each key it holds has a q-digest of its
+values.  When a new key takes over the counter of the key with the
+least count, it also takes over that key's digest, emptied.  No digest
+owns nodes: they all take them from the free list of one pool digest
+(QD_ListShare), and an emptied digest gives them back.  So the many
+keys with few values cost a few nodes each, and the nodes go where the
+values are.
+
+The pool is checked before every insert.  When fewer than logu+2 nodes
+are free (enough for any one insert), the digests of the keys with the
+least counts are emptied until an eighth of the pool is free.  These
+keys are the next to be evicted anyway.  A key's quantiles therefore
+cover the values since it was last given a counter or emptied, and
+their weight is reported with them.
+
+This work is licensed under the Creative Commons
+Attribution-NonCommercial License. To view a copy of this license,
+visit http://creativecommons.org/licenses/by-nc/1.0/ or send a letter
+to Creative Commons, 559 Nathan Abbott Way, Stanford, California
+94305, USA.
+*********************************************************************/
+
+LCLQ_type * LCLQ_Init(float fPhi, double eps, int logu, int nodes)
+{
+	LCLQ_type * lq;
+	int i, full;
+
+	lq=(LCLQ_type *) calloc(1,sizeof(LCLQ_type));
+	if (!lq)
+	{
+		fprintf(stderr,"Out of memory error allocating keys with quantiles\n");
+		exit(1);
+	}
+	if (logu<1) logu=1;
+	if (logu>32) logu=32;
+	lq->logu=logu;
+	lq->lcl=LCL_Init(fPhi);
+	// one digest must be able to grow to its usual size on its own
+	full=20+QDSCALE*(int) (1.0+logu/eps);
+	if (nodes<=0)
+		nodes=LCLQ_KEYNODES*lq->lcl->size+LCLQ_FULL*full;
+	if (nodes<2*full)
+		nodes=2*full;
+	lq->nodes=nodes;
+	lq->pool=QD_Init(eps,logu,nodes);
+	lq->spare=(QD_type **) calloc(lq->lcl->size,sizeof(QD_type *));
+	if (!lq->spare)
+	{
+		fprintf(stderr,"Out of memory error allocating keys with quantiles\n");
+		exit(1);
+	}
+	for (i=0;i<lq->lcl->size;i++)
+	{
+		lq->spare[i]=QD_Init(eps,logu,0);
+		QD_ListShare(lq->pool,lq->spare[i]);
+	}
+	lq->nspare=lq->lcl->size;
+	lq->digests=new std::unordered_map<LCLitem_t, QD_type *>();
+	return lq;
+}
+
+void LCLQ_Destroy(LCLQ_type * lq)
+{
+	std::unordered_map<LCLitem_t, QD_type *>::iterator d;
+	int i;
+
+	if (!lq) return;
+	for (d=lq->digests->begin();d!=lq->digests->end();++d)
+		QD_Destroy(d->second);
+	for (i=0;i<lq->nspare;i++)
+		QD_Destroy(lq->spare[i]);
+	QD_Destroy(lq->pool); // after the digests that share its nodes
+	LCL_Destroy(lq->lcl);
+	delete lq->digests;
+	free(lq->spare);
+	free(lq);
+}
+
+static inline int LCLQ_Free(LCLQ_type * lq)
+{ // nodes left in the pool
+	return lq->nodes-*lq->pool->a->freept;
+}
+
+static bool LCLQ_Lighter(const std::pair<long long, QD_type *> & a,
+	const std::pair<long long, QD_type *> & b)
+{
+	return a.first<b.first;
+}
+
+static void LCLQ_Reclaim(LCLQ_type * lq, QD_type * keep)
+{
+	// empty the digests of the keys with the least counts, until an
+	// eighth of the pool is free; keep goes last
+	std::vector<std::pair<long long, QD_type *> > keys;
+	std::unordered_map<LCLitem_t, QD_type *>::iterator d;
+	size_t i;
+
+	for (d=lq->digests->begin();d!=lq->digests->end();++d)
+		if (d->second!=keep && d->second->a->n>0)
+			keys.push_back(std::make_pair(
+				(long long) LCL_PointEst(lq->lcl,d->first),d->second));
+	std::sort(keys.begin(),keys.end(),LCLQ_Lighter);
+	for (i=0;i<keys.size() && LCLQ_Free(lq)<lq->nodes/8;i++)
+		QD_Clear(keys[i].second);
+	if (LCLQ_Free(lq)<lq->logu+2)
+		QD_Clear(keep);
+}
+
+void LCLQ_Update(LCLQ_type * lq, LCLitem_t item, unsigned int value,
+	LCLweight_t wt)
+{
+	std::unordered_map<LCLitem_t, QD_type *>::iterator d;
+	LCLitem_t victim;
+	QD_type * qd;
+
+	victim=lq->lcl->root->item;
+	if (LCL_FindItem(lq->lcl,item))
+		victim=item; // no change of keys
+	LCL_Update(lq->lcl,item,wt);
+	if (victim==item)
+		qd=(*lq->digests)[item];
+	else
+	{ // the key has taken the counter of victim, and takes its digest
+		d=lq->digests->find(victim);
+		if (d!=lq->digests->end())
+		{
+			qd=d->second;
+			lq->digests->erase(d);
+			QD_Clear(qd);
+		}
+		else
+			qd=lq->spare[--lq->nspare]; // the counter was unused
+		(*lq->digests)[item]=qd;
+	}
+	if (value>>(lq->logu-1)>>1) // out of range: keep the largest value
+		value=(lq->logu==32) ? 0xFFFFFFFFu : (1u<<lq->logu)-1;
+	if (LCLQ_Free(lq)<lq->logu+2)
+		LCLQ_Reclaim(lq,qd);
+	QD_Insert(qd,value,wt);
+}
+
+void LCLQ_UpdateBatch(LCLQ_type * lq, const LCLitem_t * items,
+	const unsigned int * values, const LCLweight_t * weights, int n)
+{ // the same as calling LCLQ_Update on each pair in turn
+	int i;
+
+	for (i=0;i<n;i++)
+		LCLQ_Update(lq,items[i],values[i],weights ? weights[i] : 1);
+}
+
+int LCLQ_Size(LCLQ_type * lq)
+{ // return the size of the data structure in bytes
+	return sizeof(LCLQ_type)+LCL_Size(lq->lcl)+lq->pool->bytes+
+		lq->lcl->size*(sizeof(QD_type)+sizeof(QD_admin)+
+			sizeof(LCLitem_t)+3*sizeof(void *));
+}
+
+long long LCLQ_PointEst(LCLQ_type * lq, LCLitem_t item)
+{
+	return LCL_PointEst(lq->lcl,item);
+}
+
+long long LCLQ_PointErr(LCLQ_type * lq, LCLitem_t item)
+{
+	if (LCL_FindItem(lq->lcl,item))
+		return LCL_PointErr(lq->lcl,item);
+	return lq->lcl->root->count;
+}
+
+long long LCLQ_Quantiles(LCLQ_type * lq, LCLitem_t item, const double * phis,
+	int n, unsigned int * out)
+{
+	std::unordered_map<LCLitem_t, QD_type *>::iterator d;
+	int i;
+
+	d=lq->digests->find(item);
+	if (d==lq->digests->end() || d->second->a->n==0)
+	{
+		for (i=0;i<n;i++)
+			out[i]=0;
+		return 0;
+	}
+	QD_OutputQuantiles(d->second,phis,n,out);
+	return d->second->a->n;
+}
+
+static bool LCLQ_Heavier(const LCLQKey & a, const LCLQKey & b)
+{
+	if (a.count!=b.count) return a.count>b.count;
+	return a.item<b.item;
+}
+
+std::vector<LCLQKey> LCLQ_Output(LCLQ_type * lq, int thresh,
+	const double * phis, int n)
+{
+	std::vector<LCLQKey> res;
+	LCLQKey k;
+	LCLCounter * c;
+	int i;
+
+	for (i=1;i<=lq->lcl->size;i++)
+	{
+		c=&lq->lcl->counters[i];
+		if (c->count<=0 || c->count<thresh) continue; // unused, or light
+		k.item=c->item;
+		k.count=c->count;
+		k.err=c->delta;
+		k.quantiles.resize(n);
+		k.n=LCLQ_Quantiles(lq,k.item,phis,n,n ? &k.quantiles[0] : NULL);
+		res.push_back(k);
+	}
+	std::sort(res.begin(),res.end(),LCLQ_Heavier);
+	return res;
+}
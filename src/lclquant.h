@@ -0,0 +1,61 @@
+// lclquant.h -- header file for heavy keys with quantiles of a value
+// an LCL summary of the keys (see lossycount.h), where every monitored
+// key also has a q-digest of the values that came with it (see
+// qdigest.h); all the digests take their nodes from one shared pool
+
+#ifndef LCLQUANT_h
+#define LCLQUANT_h
+
+#include <vector>
+#include <unordered_map>
+#include "lossycount.h"
+#include "qdigest.h"
+
+#define LCLQ_KEYNODES 32 // default pool: this many nodes per counter,
+#define LCLQ_FULL 8      // and room for this many full digests
+
+typedef struct LCLQ_type
+{
+  LCL_type * lcl;   // the keys
+  QD_type * pool;   // a digest that owns the nodes, and is not used
+  QD_type ** spare; // digests of no key, taken by keys as they come
+  int nspare;
+  int nodes;        // size of the pool
+  int logu;         // values are in [0, 2^logu)
+  std::unordered_map<LCLitem_t, QD_type *> * digests; // per monitored key
+} LCLQ_type;
+
+typedef struct lclqkey_t
+{
+  LCLitem_t item;
+  long long count;  // estimated count of the key
+  long long err;    // worst case error of the count
+  long long n;      // weight of the values in its digest
+  std::vector<unsigned int> quantiles;
+} LCLQKey;
+
+extern LCLQ_type * LCLQ_Init(float fPhi, double eps, int logu, int nodes);
+// about 1/fPhi keys, each with a q-digest of accuracy eps over values in
+// [0, 2^logu).  The digests share a pool of nodes (0 for the default).
+// When it runs low, the digests of the keys with the least counts are
+// emptied to make room: their values then cover less of their count
+extern void LCLQ_Destroy(LCLQ_type *);
+extern void LCLQ_Update(LCLQ_type *, LCLitem_t, unsigned int, LCLweight_t);
+// a key, a value and a weight
+extern void LCLQ_UpdateBatch(LCLQ_type *, const LCLitem_t *,
+                             const unsigned int *, const LCLweight_t *, int);
+// keys, values, weights (NULL for all ones), number of pairs
+extern int LCLQ_Size(LCLQ_type *);
+extern long long LCLQ_PointEst(LCLQ_type *, LCLitem_t);
+extern long long LCLQ_PointErr(LCLQ_type *, LCLitem_t);
+extern long long LCLQ_Quantiles(LCLQ_type *, LCLitem_t, const double *, int,
+                                unsigned int *);
+// quantiles phis[0..n-1] of the values of a key, into out[0..n-1].
+// Returns the weight of the values they are taken from: those since the
+// key was last given a counter, or its digest last emptied (0 if none)
+extern std::vector<LCLQKey> LCLQ_Output(LCLQ_type *, int, const double *,
+                                        int);
+// every key with a count of thresh or more, with quantiles phis[0..n-1]
+// of its values, largest count first
+
+#endif
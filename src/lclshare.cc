@@ -0,0 +1,294 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "lclshare.h"
+/********************************************************************
+An LCL summary shared with reader processes through snapshots
+
+The shared memory holds a page describing the snapshots, and two slots:
+
+  [ region ] [ slot 0 ] [ slot 1 ]
+
+An LCL summary is one arena (see LCL_Relocate), so a snapshot is just a
+copy of its bytes.  The writer copies the summary into the slot that
+readers were not sent to, bracketed by a sequence number of the slot
+that is odd while the copy is under way, and then publishes the slot.
+The summary itself stays in the writer's memory, so updates run exactly
+as before, and the writer never waits for a reader.
+
+Readers do not copy or relocate a snapshot: they query it where it is,
+moving each pointer by the distance between the writer's summary (the
+base recorded in the image) and the slot.  A reader does not write to
+the shared memory at all.  If the sequence number of its slot has
+changed by the end of a query, the writer has started on that slot
+again, and the query is repeated on the newer snapshot.  Since what was
+read may then be torn, every pointer and size is checked against the
+image before it is followed.
+
+This work is licensed under the Creative Commons
+Attribution-NonCommercial License. To view a copy of this license,
+visit http://creativecommons.org/licenses/by-nc/1.0/ or send a letter
+to Creative Commons, 559 Nathan Abbott Way, Stanford, California
+94305, USA.
+*********************************************************************/
+
+static inline char * LCLS_Slot(LCLS_Region * r, int slot)
+{
+	return (char *) r+LCLS_PAGE+slot*r->slotbytes;
+}
+
+static LCLS_type * LCLS_Map(const char * name, int fd, size_t bytes,
+	int writer)
+{
+	LCLS_type * ls;
+
+	ls=(LCLS_type *) calloc(1,sizeof(LCLS_type));
+	if (!ls)
+	{
+		fprintf(stderr,"Out of memory error in LCLS_Map\n");
+		exit(1);
+	}
+	ls->writer=writer;
+	ls->name=strdup(name);
+	ls->mapbytes=bytes;
+	ls->region=(LCLS_Region *) mmap(NULL,bytes,
+		writer ? PROT_READ|PROT_WRITE : PROT_READ,MAP_SHARED,fd,0);
+	close(fd);
+	if (ls->region==MAP_FAILED || !ls->name)
+	{
+		fprintf(stderr,"Out of memory error mapping %s\n",name);
+		exit(1);
+	}
+	return ls;
+}
+
+LCLS_type * LCLS_Create(const char * name, LCL_type * lcl)
+{
+	LCLS_type * ls;
+	LCLS_Region * r;
+	size_t slotbytes;
+	int fd;
+
+	// anything left under name by a writer that did not close is
+	// replaced; readers still attached to it keep their mapping
+	shm_unlink(name);
+	fd=shm_open(name,O_RDWR|O_CREAT|O_EXCL,0644);
+	slotbytes=(lcl->bytes+LCLS_PAGE-1)/LCLS_PAGE*LCLS_PAGE;
+	if (fd<0 || ftruncate(fd,LCLS_PAGE+2*slotbytes)!=0)
+	{
+		fprintf(stderr,"Error: cannot create %s: %s\n",name,strerror(errno));
+		if (fd>=0)
+		{
+			close(fd);
+			shm_unlink(name);
+		}
+		return NULL;
+	}
+	ls=LCLS_Map(name,fd,LCLS_PAGE+2*slotbytes,1);
+	r=ls->region;
+	r->version=LCLS_VERSION;
+	r->structsize=LCL_LAYOUT;
+	r->bytes=lcl->bytes;
+	r->slotbytes=slotbytes;
+	LCLS_Publish(ls,lcl);
+	// readers only look at the rest once magic is set
+	__atomic_store_n(&r->magic,LCLS_MAGIC,__ATOMIC_RELEASE);
+	return ls;
+}
+
+int LCLS_Publish(LCLS_type * ls, LCL_type * lcl)
+{
+	LCLS_Region * r=ls->region;
+	uint64_t p;
+	int slot;
+
+	if (!ls->writer || lcl->bytes!=r->bytes) return 0;
+	// the slot readers were not sent to: a reader still on it from two
+	// snapshots ago sees its sequence number change, and starts again
+	p=r->published+1;
+	slot=(int) (p%2);
+	__atomic_store_n(&r->seq[slot],r->seq[slot]+1,__ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memcpy(LCLS_Slot(r,slot),lcl,lcl->bytes);
+	__atomic_store_n(&r->seq[slot],r->seq[slot]+1,__ATOMIC_RELEASE);
+	__atomic_store_n(&r->published,p,__ATOMIC_RELEASE);
+	return 1;
+}
+
+LCLS_type * LCLS_Attach(const char * name)
+{
+	LCLS_type * ls;
+	LCLS_Region * r;
+	struct stat st;
+	int fd;
+
+	fd=shm_open(name,O_RDONLY,0);
+	if (fd<0 || fstat(fd,&st)!=0 || st.st_size<LCLS_PAGE)
+	{
+		fprintf(stderr,"Error: cannot attach to %s: %s\n",name,
+			(fd<0 || st.st_size>=LCLS_PAGE) ? strerror(errno) :
+			"no summary is shared there yet");
+		if (fd>=0) close(fd);
+		return NULL;
+	}
+	ls=LCLS_Map(name,fd,st.st_size,0);
+	r=ls->region;
+	if (__atomic_load_n(&r->magic,__ATOMIC_ACQUIRE)!=LCLS_MAGIC ||
+		r->version!=LCLS_VERSION || r->structsize!=LCL_LAYOUT ||
+		LCLS_PAGE+2*r->slotbytes!=(uint64_t) st.st_size)
+	{
+		fprintf(stderr,"Error: %s holds no summary yet, or one made by a "
+			"different build\n",name);
+		LCLS_Close(ls);
+		return NULL;
+	}
+	return ls;
+}
+
+uint64_t LCLS_Version(LCLS_type * ls)
+{
+	return __atomic_load_n(&ls->region->published,__ATOMIC_ACQUIRE);
+}
+
+static const char * LCLS_Begin(LCLS_type * ls, int * slot, uint64_t * seq)
+{ // the image of the last snapshot, and the sequence number of its slot
+	LCLS_Region * r=ls->region;
+	uint64_t p;
+
+	while (1)
+	{
+		p=__atomic_load_n(&r->published,__ATOMIC_ACQUIRE);
+		*slot=(int) (p%2);
+		*seq=__atomic_load_n(&r->seq[*slot],__ATOMIC_ACQUIRE);
+		if (*seq%2==0) break;
+		// being written again, so a newer snapshot has been published
+	}
+	return LCLS_Slot(r,*slot);
+}
+
+static int LCLS_End(LCLS_type * ls, int slot, uint64_t seq)
+{ // whether the slot was left alone while it was read
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(&ls->region->seq[slot],__ATOMIC_RELAXED)==seq;
+}
+
+static inline const void * LCLS_At(const char * img, const LCL_type * h,
+	const void * p, size_t n)
+{ // where the writer's pointer p is in img, or NULL if p..p+n is not in it
+	uintptr_t off=(uintptr_t) p-(uintptr_t) h->base;
+
+	if (off>=h->bytes || n>h->bytes-off) return NULL;
+	return img+off;
+}
+
+static int LCLS_Header(LCLS_type * ls, const char * img, LCL_type * h)
+{ // a copy of the header of the image, or 0 if it cannot be right
+	memcpy(h,img,sizeof(LCL_type));
+	return h->bytes==ls->region->bytes && h->hashsize>0 &&
+		h->size>0 && (size_t) h->size<h->bytes/sizeof(LCLCounter);
+}
+
+static int LCLS_Find(LCLS_type * ls, const char * img, LCLitem_t item,
+	LCLweight_t * est, LCLweight_t * err)
+{
+	// look item up in the image as LCL_PointEst and LCL_PointErr do.
+	// Returns 0 if the image turns out to be torn
+	LCL_type h;
+	LCLCounter * const * table;
+	const LCLCounter * c, * root;
+	LCLCounter * p;
+	int hashval, steps;
+
+	if (!LCLS_Header(ls,img,&h)) return 0;
+	table=(LCLCounter * const *) LCLS_At(img,&h,h.hashtable,
+		h.hashsize*sizeof(LCLCounter *));
+	root=(const LCLCounter *) LCLS_At(img,&h,h.root,sizeof(LCLCounter));
+	if (!table || !root) return 0;
+
+	hashval=(int) hash31(h.hasha, h.hashb,item) % h.hashsize;
+	p=table[hashval];
+	for (steps=0;p;steps++)
+	{
+		c=(const LCLCounter *) LCLS_At(img,&h,p,sizeof(LCLCounter));
+		if (!c || steps>h.size) return 0; // not a chain of this image
+		if (c->item==item)
+		{
+			*est=c->count;
+			*err=c->delta;
+			return 1;
+		}
+		p=c->next;
+	}
+	*est=0;
+	*err=root->delta;
+	return 1;
+}
+
+LCLweight_t LCLS_PointEst(LCLS_type * ls, LCLitem_t item)
+{
+	const char * img;
+	LCLweight_t est, err;
+	uint64_t seq;
+	int slot, ok;
+
+	do {
+		img=LCLS_Begin(ls,&slot,&seq);
+		ok=LCLS_Find(ls,img,item,&est,&err);
+	} while (!LCLS_End(ls,slot,seq) || !ok);
+	return est;
+}
+
+LCLweight_t LCLS_PointErr(LCLS_type * ls, LCLitem_t item)
+{
+	const char * img;
+	LCLweight_t est, err;
+	uint64_t seq;
+	int slot, ok;
+
+	do {
+		img=LCLS_Begin(ls,&slot,&seq);
+		ok=LCLS_Find(ls,img,item,&est,&err);
+	} while (!LCLS_End(ls,slot,seq) || !ok);
+	return err;
+}
+
+std::map<uint32_t, uint32_t> LCLS_Output(LCLS_type * ls, int thresh)
+{
+	std::map<uint32_t, uint32_t> res;
+	const LCLCounter * counters;
+	const char * img;
+	LCL_type h;
+	uint64_t seq;
+	int slot, ok, i;
+
+	do {
+		res.clear();
+		img=LCLS_Begin(ls,&slot,&seq);
+		ok=LCLS_Header(ls,img,&h);
+		counters=(ok) ? (const LCLCounter *) LCLS_At(img,&h,h.counters,
+			(1+h.size)*sizeof(LCLCounter)) : NULL;
+		if (counters)
+			for (i=1;i<=h.size;++i)
+			{
+				if (counters[i].count>=thresh)
+					res.insert(std::pair<uint32_t, uint32_t>(counters[i].item,
+						counters[i].count));
+			}
+	} while (!LCLS_End(ls,slot,seq) || !counters);
+	return res;
+}
+
+void LCLS_Close(LCLS_type * ls)
+{
+	if (!ls) return;
+	munmap(ls->region,ls->mapbytes);
+	if (ls->writer) shm_unlink(ls->name);
+	free(ls->name);
+	free(ls);
+}
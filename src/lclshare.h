@@ -0,0 +1,53 @@
+// lclshare.h -- header file for sharing an LCL summary between processes
+// the updating process publishes snapshots of its summary to shared
+// memory, and other processes query them without locks
+
+#ifndef LCLSHARE_h
+#define LCLSHARE_h
+
+#include "lossycount.h"
+
+#define LCLS_PAGE 4096 // the shared memory is laid out in whole pages
+#define LCLS_MAGIC 0x53534C43 // "CLSS"
+#define LCLS_VERSION 1
+
+typedef struct lcls_region_t
+{ // the first page of the shared memory, followed by two snapshot slots
+  uint32_t magic;      // set once the first snapshot is in place
+  uint32_t version;
+  uint32_t structsize; // LCL_LAYOUT of the writer's build
+  uint32_t unused;
+  uint64_t bytes;      // size of a snapshot image
+  uint64_t slotbytes;  // bytes rounded up to whole pages
+  uint64_t published;  // number of the last snapshot, kept in slot
+                       // published%2; only the writer changes it
+  uint64_t seq[2];     // odd while slot i is being written
+} LCLS_Region;
+
+typedef struct LCLS_type
+{
+  int writer;          // this process publishes, and removes the name
+  char *name;
+  size_t mapbytes;     // size of the mapping
+  LCLS_Region *region; // the mapping: the region page, then the slots
+} LCLS_type;
+
+extern LCLS_type * LCLS_Create(const char * name, LCL_type * lcl);
+// share lcl under name (as for shm_open), and publish a first snapshot.
+// Returns NULL if name cannot be created
+extern int LCLS_Publish(LCLS_type *, LCL_type *);
+// publish a snapshot of the summary given to LCLS_Create.  This costs the
+// writer one copy of the summary, and never waits for readers
+extern LCLS_type * LCLS_Attach(const char * name);
+// map the snapshots shared under name, for reading.  Returns NULL if
+// there are none, or they were made by a different build
+extern uint64_t LCLS_Version(LCLS_type *); // number of the last snapshot
+extern LCLweight_t LCLS_PointEst(LCLS_type *, LCLitem_t);
+extern LCLweight_t LCLS_PointErr(LCLS_type *, LCLitem_t);
+extern std::map<uint32_t, uint32_t> LCLS_Output(LCLS_type *, int);
+// the same answers as LCL_PointEst, LCL_PointErr and LCL_Output on the
+// last snapshot.  Readers take no locks, and write nothing to the shared
+// memory; a query that overlaps the rewriting of its slot is repeated
+extern void LCLS_Close(LCLS_type *); // the writer also removes the name
+
+#endif
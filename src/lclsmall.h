@@ -0,0 +1,161 @@
+// lclsmall.h -- Lazy Lossy Counting (Space Saving) for small, fixed k
+// see Metwally, Agrawal, El Abbadi, ICDT 2005 for the algorithm
+//
+// LCLK_type<K> keeps the same summary as LCL_type with k=K counters, but
+// with K fixed at compile time and no heap or hash table: the items and
+// counts sit in aligned arrays of a few cache lines, and both the lookup
+// and the search for the smallest counter are fixed-length vector scans
+// with no data-dependent branches.  It is meant for keeping many tiny
+// summaries (per-tenant top-10s, say), and answers to the same calls as
+// LCL_type:
+//
+//   LCLK_type<16> * t=LCLK_Init<16>();
+//   LCL_Update(t,item,1);
+//   LCL_PointEst(t,item); LCL_Output(t,thresh); LCL_Destroy(t);
+//
+// K must be a multiple of LCLK_LANES and at most 64.  A summary can also
+// be embedded in a larger structure and set up with LCLK_Clear.
+
+#ifndef LCLSMALL_h
+#define LCLSMALL_h
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "lossycount.h"
+#include "smallscan.h"
+
+#define LCLK_LANES SCAN_LANES // counters are compared eight at a time
+#define LCLK_MAX SCAN_CHUNK   // a whole scan is one chunk of smallscan.h
+
+template<int K> struct LCLK_type
+{
+  static_assert(K>0 && K%LCLK_LANES==0 && K<=LCLK_MAX,
+    "LCLK_type: K must be a multiple of 8, at most 64");
+  alignas(64) LCLitem_t items[K]; // item identifiers
+  alignas(64) LCLweight_t counts[K]; // (upper bound on) count for the item,
+                  // 0 if the counter is unused
+  LCLweight_t deltas[K]; // max possible error in count for the item
+  LCLweight_t n; // total weight of updates received
+};
+
+template<int K> void LCLK_Clear(LCLK_type<K> * lcl)
+{ // every counter unused
+  memset(lcl,0,sizeof(LCLK_type<K>));
+}
+
+template<int K> LCLK_type<K> * LCLK_Init()
+{
+  LCLK_type<K> * lcl;
+
+  lcl=(LCLK_type<K> *) aligned_alloc(64,
+    (sizeof(LCLK_type<K>)+63) & ~((size_t) 63));
+  if (!lcl)
+  {
+    fprintf(stderr,"Out of memory error allocating %d counters\n",K);
+    exit(1);
+  }
+  LCLK_Clear(lcl);
+  return lcl;
+}
+
+template<int K> void LCL_Destroy(LCLK_type<K> * lcl)
+{
+  free(lcl);
+}
+
+template<int K> static inline int LCLK_FindScalar(const LCLK_type<K> * lcl,
+  LCLitem_t item)
+{ // the counter holding item, or -1
+  uint64_t m=0;
+  int i;
+
+  for (i=0;i<K;i++)
+    m|=(uint64_t) (lcl->items[i]==item && lcl->counts[i]>0)<<i;
+  return m ? __builtin_ctzll(m) : -1;
+}
+
+template<int K> static inline int LCLK_MinScalar(const LCLK_type<K> * lcl)
+{ // the first counter with the smallest count
+  int i, best=0;
+
+  for (i=1;i<K;i++)
+    best=(lcl->counts[i]<lcl->counts[best]) ? i : best;
+  return best;
+}
+
+template<int K> static inline int LCLK_Find(const LCLK_type<K> * lcl,
+  LCLitem_t item)
+{
+#ifdef SCAN_AVX2
+  if (SCAN_UseAVX2())
+    return SCAN_FindAVX2(lcl->counts,lcl->items,K,item,0,NULL);
+#endif
+  return LCLK_FindScalar(lcl,item);
+}
+
+template<int K> static inline int LCLK_Min(const LCLK_type<K> * lcl)
+{
+#ifdef SCAN_AVX2
+  if (SCAN_UseAVX2()) return SCAN_MinAVX2(lcl->counts,K);
+#endif
+  return LCLK_MinScalar(lcl);
+}
+
+template<int K> void LCL_Update(LCLK_type<K> * lcl, LCLitem_t item,
+  LCLweight_t value)
+{
+  int i;
+
+  lcl->n+=value;
+  i=LCLK_Find(lcl,item);
+  if (i<0)
+  { // not monitored: take over the smallest counter, whose count is the
+    // most that item could have had so far (unused counters count 0)
+    i=LCLK_Min(lcl);
+    lcl->items[i]=item;
+    lcl->deltas[i]=lcl->counts[i];
+  }
+  lcl->counts[i]+=value;
+}
+
+template<int K> void LCL_UpdateBatch(LCLK_type<K> * lcl,
+  const LCLitem_t * items, const LCLweight_t * weights, int n)
+{ // the same as LCL_Update on each item in turn; weights may be NULL
+  int i;
+
+  for (i=0;i<n;i++)
+    LCL_Update(lcl,items[i],weights ? weights[i] : 1);
+}
+
+template<int K> int LCL_Size(LCLK_type<K> *)
+{ // return the size of the data structure in bytes
+  return sizeof(LCLK_type<K>);
+}
+
+template<int K> LCLweight_t LCL_PointEst(LCLK_type<K> * lcl, LCLitem_t item)
+{ // estimate the count of a particular item
+  int i=LCLK_Find(lcl,item);
+  return (i>=0) ? lcl->counts[i] : 0;
+}
+
+template<int K> LCLweight_t LCL_PointErr(LCLK_type<K> * lcl, LCLitem_t item)
+{ // estimate the worst case error in the estimate of a particular item
+  int i=LCLK_Find(lcl,item);
+  return (i>=0) ? lcl->deltas[i] : lcl->counts[LCLK_Min(lcl)];
+}
+
+template<int K> std::map<uint32_t, uint32_t> LCL_Output(LCLK_type<K> * lcl,
+  int thresh)
+{
+  std::map<uint32_t, uint32_t> res;
+  int i;
+
+  for (i=0;i<K;i++)
+    if (lcl->counts[i]>0 && lcl->counts[i]>=thresh)
+      res.insert(std::pair<uint32_t, uint32_t>(lcl->items[i],
+        lcl->counts[i]));
+  return res;
+}
+
+#endif
@@ -0,0 +1,214 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "lclwindow.h"
+/********************************************************************
+Heavy hitters over a sliding window, from panes of LCL summaries
+
+The window is cut into panes of fixed length.  Updates go to the LCL
+summary of the open pane.  When time moves into the next pane, the open
+pane is closed: each of its counters is added to an aggregate of the
+closed panes, kept per item.  The pane that falls out of the window is
+subtracted from the aggregate again, and its summary is reused for the
+new open pane.  A query then looks at the aggregate and at the open
+pane only, not at every pane.
+
+A pane that holds an item gives its count to within the delta of the
+counter.  A pane that does not hold the item saw it at most as often as
+its least count, which is at most fPhi times the weight of the pane.
+The aggregate keeps, per item, the sums of counts and deltas, and of
+the least counts of the panes that hold the item; together with the sum
+of the least counts of all closed panes this bounds the error of the
+window count, with no per-pane work at query time.
+
+This work is licensed under the Creative Commons
+Attribution-NonCommercial License. To view a copy of this license,
+visit http://creativecommons.org/licenses/by-nc/1.0/ or send a letter
+to Creative Commons, 559 Nathan Abbott Way, Stanford, California
+94305, USA.
+*********************************************************************/
+
+WLCL_type * WLCL_Init(float fPhi, int panes, WLCLtime_t width)
+{
+	WLCL_type * wlcl;
+	int i;
+
+	if (panes<1) panes=1;
+	wlcl=(WLCL_type *) calloc(1,sizeof(WLCL_type));
+	if (wlcl) wlcl->ring=(LCL_type **) calloc(panes,sizeof(LCL_type *));
+	if (!wlcl || !wlcl->ring)
+	{
+		fprintf(stderr,"Out of memory error allocating a window\n");
+		exit(1);
+	}
+	wlcl->panes=panes;
+	wlcl->width=width;
+	wlcl->fresh=LCL_Init(fPhi);
+	for (i=0;i<panes;i++)
+		wlcl->ring[i]=LCL_Clone(wlcl->fresh);
+	wlcl->agg=new std::unordered_map<LCLitem_t, WLCLAgg>();
+	return wlcl;
+}
+
+void WLCL_Destroy(WLCL_type * wlcl)
+{
+	int i;
+
+	if (!wlcl) return;
+	for (i=0;i<wlcl->panes;i++)
+		LCL_Destroy(wlcl->ring[i]);
+	LCL_Destroy(wlcl->fresh);
+	delete wlcl->agg;
+	free(wlcl->ring);
+	free(wlcl);
+}
+
+static inline LCL_type * WLCL_Pane(WLCL_type * wlcl, long long p)
+{
+	return wlcl->ring[((p%wlcl->panes)+wlcl->panes)%wlcl->panes];
+}
+
+static void WLCL_Fold(WLCL_type * wlcl, LCL_type * lcl, int sign)
+{
+	// add the counters of a closed pane to the aggregate (sign 1), or take
+	// them out again when the pane leaves the window (sign -1)
+	std::unordered_map<LCLitem_t, WLCLAgg>::iterator a;
+	LCLCounter * c;
+	LCLweight_t least;
+	int i;
+
+	least=lcl->root->count;
+	wlcl->n+=sign*(long long) lcl->n;
+	wlcl->mins+=sign*(long long) least;
+	for (i=1;i<=lcl->size;i++)
+	{
+		c=&lcl->counters[i];
+		if (c->count<=0) continue; // unused
+		a=wlcl->agg->find(c->item);
+		if (a==wlcl->agg->end())
+			a=wlcl->agg->insert(std::make_pair(c->item,WLCLAgg())).first;
+		a->second.count+=sign*(long long) c->count;
+		a->second.delta+=sign*(long long) c->delta;
+		a->second.mins+=sign*(long long) least;
+		a->second.panes+=sign;
+		if (a->second.panes==0) wlcl->agg->erase(a);
+	}
+}
+
+static void WLCL_Reset(WLCL_type * wlcl, LCL_type * lcl)
+{ // empty a pane by copying the empty summary over it
+	memcpy(lcl,wlcl->fresh,wlcl->fresh->bytes);
+	LCL_Relocate(lcl);
+}
+
+void WLCL_Advance(WLCL_type * wlcl, WLCLtime_t t)
+{
+	long long p;
+	int i;
+
+	p=(long long) floor(t/wlcl->width);
+	if (!wlcl->started)
+	{
+		wlcl->pane=p;
+		wlcl->started=1;
+		return;
+	}
+	if (p<=wlcl->pane) return;
+	if (p-wlcl->pane>=wlcl->panes)
+	{ // the whole window has gone by: start again from empty
+		for (i=0;i<wlcl->panes;i++)
+			WLCL_Reset(wlcl,wlcl->ring[i]);
+		wlcl->agg->clear();
+		wlcl->n=0;
+		wlcl->mins=0;
+		wlcl->pane=p;
+		return;
+	}
+	while (wlcl->pane<p)
+	{
+		WLCL_Fold(wlcl,WLCL_Pane(wlcl,wlcl->pane),1); // close the open pane
+		wlcl->pane++;
+		// the pane panes back shares its place in the ring with the new
+		// open pane: it leaves the window, and is reused
+		WLCL_Fold(wlcl,WLCL_Pane(wlcl,wlcl->pane),-1);
+		WLCL_Reset(wlcl,WLCL_Pane(wlcl,wlcl->pane));
+	}
+}
+
+void WLCL_Update(WLCL_type * wlcl, LCLitem_t item, WLCLtime_t t,
+	LCLweight_t value)
+{
+	WLCL_Advance(wlcl,t);
+	LCL_Update(WLCL_Pane(wlcl,wlcl->pane),item,value);
+}
+
+int WLCL_Size(WLCL_type * wlcl)
+{ // return the size of the data structure in bytes
+	return sizeof(WLCL_type)+(wlcl->panes+1)*LCL_Size(wlcl->fresh)+
+		wlcl->agg->size()*(sizeof(LCLitem_t)+sizeof(WLCLAgg)+2*sizeof(void *));
+}
+
+long long WLCL_Total(WLCL_type * wlcl)
+{
+	return wlcl->n+WLCL_Pane(wlcl,wlcl->pane)->n;
+}
+
+long long WLCL_PointEst(WLCL_type * wlcl, LCLitem_t item)
+{ // estimate the count of a particular item in the window
+	std::unordered_map<LCLitem_t, WLCLAgg>::iterator a;
+	long long est;
+
+	est=LCL_PointEst(WLCL_Pane(wlcl,wlcl->pane),item);
+	a=wlcl->agg->find(item);
+	if (a!=wlcl->agg->end())
+		est+=a->second.count;
+	return est;
+}
+
+long long WLCL_PointErr(WLCL_type * wlcl, LCLitem_t item)
+{
+	// the worst case error in the estimate of a particular item: the
+	// deltas of the panes that hold it, and the least counts of the
+	// panes that do not
+	std::unordered_map<LCLitem_t, WLCLAgg>::iterator a;
+	LCL_type * open=WLCL_Pane(wlcl,wlcl->pane);
+	long long err;
+
+	if (LCL_PointEst(open,item)>0)
+		err=LCL_PointErr(open,item);
+	else
+		err=open->root->count;
+	err+=wlcl->mins;
+	a=wlcl->agg->find(item);
+	if (a!=wlcl->agg->end())
+		err+=a->second.delta-a->second.mins;
+	return err;
+}
+
+std::map<uint32_t, uint32_t> WLCL_Output(WLCL_type * wlcl, int thresh)
+{
+	std::map<uint32_t, uint32_t> res, open;
+	std::map<uint32_t, uint32_t>::iterator o;
+	std::unordered_map<LCLitem_t, WLCLAgg>::iterator a;
+	long long est;
+
+	// every candidate is in the aggregate or in the open pane
+	open=LCL_Output(WLCL_Pane(wlcl,wlcl->pane),1);
+	for (a=wlcl->agg->begin();a!=wlcl->agg->end();++a)
+	{
+		est=a->second.count;
+		o=open.find(a->first);
+		if (o!=open.end())
+		{
+			est+=o->second;
+			open.erase(o);
+		}
+		if (est>=thresh)
+			res.insert(std::pair<uint32_t, uint32_t>(a->first,est));
+	}
+	for (o=open.begin();o!=open.end();++o)
+		if ((long long) o->second>=thresh)
+			res.insert(*o);
+	return res;
+}
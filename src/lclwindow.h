@@ -0,0 +1,54 @@
+// lclwindow.h -- header file for heavy hitters over a sliding window
+// the window is cut into panes of equal length, each summarised by an
+// LCL summary (see lossycount.h), and the closed panes are added up as
+// they close
+
+#ifndef LCLWINDOW_h
+#define LCLWINDOW_h
+
+#include <unordered_map>
+#include "lossycount.h"
+
+#define WLCLtime_t double
+
+typedef struct wlclagg_t
+{ // what the closed panes of the window know about one item
+  long long count; // sum of its counts in the panes that hold it
+  long long delta; // sum of the errors of those counts
+  long long mins;  // sum of the least counts of those panes
+  int panes;       // number of closed panes that hold it
+} WLCLAgg;
+
+typedef struct WLCL_type
+{
+  int panes;        // the window is the open pane and panes-1 before it
+  WLCLtime_t width; // length of a pane
+  long long pane;   // number of the open pane, which holds the times
+                    // [pane*width, (pane+1)*width)
+  int started;      // pane has been set by a first update
+  LCL_type **ring;  // pane p is summarised by ring[p%panes]
+  LCL_type *fresh;  // an empty summary, copied over a pane to reuse it
+  long long n;      // total weight of the closed panes in the window
+  long long mins;   // sum of the least counts of the closed panes
+  std::unordered_map<LCLitem_t, WLCLAgg> *agg; // closed panes, by item
+} WLCL_type;
+
+extern WLCL_type * WLCL_Init(float fPhi, int panes, WLCLtime_t width);
+// panes of about 1/fPhi counters each; the window spans between
+// (panes-1)*width and panes*width
+extern void WLCL_Destroy(WLCL_type *);
+extern void WLCL_Update(WLCL_type *, LCLitem_t, WLCLtime_t, LCLweight_t);
+// item, time, weight.  Times should not go back by more than a pane: an
+// update older than the open pane is counted in the open pane
+extern void WLCL_Advance(WLCL_type *, WLCLtime_t);
+// move the window on to the given time, with no update
+extern int WLCL_Size(WLCL_type *);
+extern long long WLCL_Total(WLCL_type *); // weight of updates in the window
+extern long long WLCL_PointEst(WLCL_type *, LCLitem_t);
+extern long long WLCL_PointErr(WLCL_type *, LCLitem_t);
+// the count of an item in the window is within PointErr of PointEst,
+// and PointErr is at most about fPhi times the weight of the window
+extern std::map<uint32_t, uint32_t> WLCL_Output(WLCL_type *, int);
+// every item whose estimated count in the window is thresh or more
+
+#endif
@@ -1,5 +1,7 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <random>
 #include "lossycount.h"
 #include "prng.h"
 /********************************************************************
@@ -39,6 +41,7 @@ void LC_Destroy(LC_type * lc)
 	free(lc->bucket);
 	free(lc->holder);
 	free(lc->newcount);
+	ST_FREE(lc->stats);
 	free(lc);
 }
 
@@ -161,6 +164,7 @@ int lccountermerge(LCCounter *newcount, LCCounter *left, LCCounter *right,
 void LC_Update(LC_type * lc, int val)
 {
 	LCCounter *tmp;
+	ST_START(lc->sc);
 
 	// interpret a negative item identifier as a removal
 	if (val>0)
@@ -177,6 +181,7 @@ void LC_Update(LC_type * lc, int val)
 	lc->buckets++;
 	if (lc->buckets==lc->window)
 	{
+		ST_EVENT(lc->sc,ST_FLUSH);
 		qsort(lc->bucket,lc->window,sizeof(LCCounter),lccmp);
 		lc->holdersize=lccountermerge(lc->newcount,lc->bucket,lc->holder,
 			lc->window,lc->holdersize,lc->maxholder);
@@ -186,6 +191,7 @@ void LC_Update(LC_type * lc, int val)
 		lc->buckets=0;
 		lc->epoch++;
 	}
+	ST_STOP(lc->stats);
 }
 
 int LC_Size(LC_type * lc)
@@ -260,6 +266,7 @@ void LCD_Destroy(LCD_type * lc)
 	free(lc->bucket);
 	free(lc->holder);
 	free(lc->newcount);
+	ST_FREE(lc->stats);
 	free(lc);
 }
 
@@ -388,6 +395,7 @@ int lcdcountermerge(LCDCounter *newcount, LCDCounter *left, LCDCounter *right,
 void LCD_Update(LCD_type * lc, int val)
 {
 	LCDCounter *tmp;
+	ST_START(lc->sc);
 	// interpret a negative item identifier as a removal
 	if (val>0)
 	{
@@ -407,6 +415,7 @@ void LCD_Update(LCD_type * lc, int val)
 	if (lc->buckets==lc->window)
 	{
 
+		ST_EVENT(lc->sc,ST_FLUSH);
 		lc->epoch++;
 		qsort(lc->bucket,lc->window,sizeof(LCDCounter),ccmp);
 		lc->holdersize=lcdcountermerge(lc->newcount,lc->bucket,lc->holder,
@@ -417,6 +426,7 @@ void LCD_Update(LCD_type * lc, int val)
 		lc->holder=tmp;
 		lc->buckets=0;
 	}
+	ST_STOP(lc->stats);
 }
 
 int LCD_Size(LCD_type * lc)
@@ -473,24 +483,129 @@ to Creative Commons, 559 Nathan Abbott Way, Stanford, California
 #define LCL_NULLITEM 0x7FFFFFFF
 	// 2^31 -1 as a special character
 
+#ifdef __GNUC__
+#define LCL_PREFETCHADDR(p) __builtin_prefetch(p)
+#else
+#define LCL_PREFETCHADDR(p) do {} while (0)
+#endif
+
+int LC_RandomSeed()
+{ // a seed for instances that are not given one, from the system
+	static std::random_device rd;
+	return (int) (rd() & 0x7FFFFFFF) | 1;
+}
+
+// LCL and LCU summaries are each laid out in one allocation, and keep
+// its size and address, so that a copy made with memcpy (or a file
+// mapped back into memory) can be put right by shifting every pointer
+// inside by the distance moved
+
+static size_t LC_Align(size_t n)
+{ // round up to a whole number of cache lines
+	return (n+63) & ~((size_t) 63);
+}
+
+void * LC_Alloc(size_t n, size_t size)
+{
+	// zeroed memory, aligned to a cache line so that copies of a summary
+	// keep the alignment of the arrays inside
+	void * p;
+	size_t bytes=LC_Align((n*size>0) ? n*size : 1);
+
+	p=aligned_alloc(64,bytes);
+	if (!p)
+	{
+		fprintf(stderr,"Out of memory error allocating %zu bytes\n",bytes);
+		exit(1);
+	}
+	memset(p,0,bytes);
+	return p;
+}
+
+static void LC_InitPrng(prng_type * prng, int seed)
+{ // the generator lives in the arena, seeded as prng_Init would
+	prng_type * p=prng_Init(-abs(seed),2);
+	*prng=*p;
+	prng_Destroy(p);
+}
+
+template<typename T> static inline void LC_Move(T *& p, ptrdiff_t d)
+{ // shift a pointer into a summary that has moved by d bytes
+	if (p) p=(T *) ((char *) p+d);
+}
+
 LCL_type * LCL_Init(float fPhi)
+{ // hash functions are picked at random: see LCL_InitSeed
+	return LCL_InitSeed(fPhi,LC_RandomSeed());
+}
+
+#ifdef LCL_HEAP_ARITY
+static void LCL_HeapBuild(LCL_type * lcl)
 {
+	// one record per counter, in the order of the counters array; this is
+	// a valid heap when the counters are sorted by count (or all zero)
 	int i;
+
+	for (i=0;i<lcl->size;i++)
+	{
+		lcl->heap[i].count=lcl->counters[i+1].count;
+		lcl->heap[i].idx=i+1;
+		lcl->heappos[i+1]=i;
+	}
+	lcl->root=&lcl->counters[lcl->heap[0].idx];
+}
+
+#endif
+
+LCL_type * LCL_InitSeed(float fPhi, int seed)
+{
+	// the seed picks the hash function parameters (and those of any
+	// later rehash), so that the same seed gives the same summary
+	int i, size, hashsize;
 	int k = 1 + (int) 1.0/fPhi;
+	size_t prngoff, hashoff, countoff, bytes;
+#ifdef LCL_HEAP_ARITY
+	size_t heapoff, posoff;
+#endif
 
-	LCL_type *result = (LCL_type *) calloc(1,sizeof(LCL_type));
 	// needs to be odd so that the heap always has either both children or 
 	// no children present in the data structure
-
-	result->size = (1 + k) | 1; // ensure that size is odd
-	result->hashsize = LCL_HASHMULT*result->size;
-	result->hashtable=(LCLCounter **) calloc(result->hashsize,sizeof(LCLCounter*));
-	result->counters=(LCLCounter*) calloc(1+result->size,sizeof(LCLCounter));
-	// indexed from 1, so add 1
-
-	result->hasha=151261303;
-	result->hashb=6722461; // hard coded constants for the hash table,
-	//should really generate these randomly
+	size = (1 + k) | 1; // ensure that size is odd
+	hashsize = LCL_HASHMULT*size;
+
+	// the struct, the generator, the hash table and the counters (indexed
+	// from 1, so add 1) in one arena, each on its own cache lines
+	prngoff=LC_Align(sizeof(LCL_type));
+	hashoff=prngoff+LC_Align(sizeof(prng_type));
+	countoff=hashoff+LC_Align(hashsize*sizeof(LCLCounter*));
+	bytes=countoff+LC_Align((1+size)*sizeof(LCLCounter));
+#ifdef LCL_HEAP_ARITY
+	// the heap records are placed so that the LCL_HEAP_ARITY children of
+	// any node, which start at heap[d*i+1], begin on a d record boundary:
+	// with d=8 they fill exactly one cache line
+	heapoff=bytes;
+	bytes+=LC_Align((size+LCL_HEAP_ARITY-1)*sizeof(LCLHeapRec));
+	posoff=bytes;
+	bytes+=LC_Align((1+size)*sizeof(int));
+#endif
+
+	LCL_type *result = (LCL_type *) LC_Alloc(1,bytes);
+	result->bytes=bytes;
+	result->base=result;
+	result->size=size;
+	result->hashsize=hashsize;
+	result->hashtable=(LCLCounter **) ((char *) result+hashoff);
+	result->counters=(LCLCounter *) ((char *) result+countoff);
+#ifdef LCL_HEAP_ARITY
+	result->heap=(LCLHeapRec *) ((char *) result+heapoff)+LCL_HEAP_ARITY-1;
+	result->heappos=(int *) ((char *) result+posoff);
+#endif
+
+	result->prng=(prng_type *) ((char *) result+prngoff);
+	LC_InitPrng(result->prng,seed);
+	result->hasha=prng_int(result->prng) & MOD;
+	result->hashb=prng_int(result->prng) & MOD;
+	// random parameters, so that colliding items cannot be picked in advance
 	result->n=(LCLweight_t) 0;
 
 	for (i=1; i<=result->size;i++)
@@ -501,14 +616,53 @@ LCL_type * LCL_Init(float fPhi)
 		// initialize items and counters to zero
 	}
 	result->root=&result->counters[1]; // put in a pointer to the top of the heap
+#ifdef LCL_HEAP_ARITY
+	LCL_HeapBuild(result);
+#endif
 	return(result);
 }
 
 void LCL_Destroy(LCL_type * lcl)
 {
-	free(lcl->hashtable);
-	free(lcl->counters);
-	free(lcl);
+	if (!lcl) return;
+	ST_FREE(lcl->stats);
+	free(lcl); // the generator and all arrays are in the same arena
+}
+
+void LCL_Relocate(LCL_type * lcl)
+{
+	// the arena has been copied from lcl->base: shift its pointers
+	ptrdiff_t d=(char *) lcl-(char *) lcl->base;
+	int i;
+
+	ST_DETACH(lcl->stats);
+	if (d==0) return;
+	LC_Move(lcl->prng,d);
+	LC_Move(lcl->hashtable,d);
+	LC_Move(lcl->counters,d);
+	LC_Move(lcl->root,d);
+#ifdef LCL_HEAP_ARITY
+	LC_Move(lcl->heap,d);
+	LC_Move(lcl->heappos,d);
+#endif
+	for (i=0;i<lcl->hashsize;i++)
+		LC_Move(lcl->hashtable[i],d);
+	for (i=1;i<=lcl->size;i++)
+	{
+		LC_Move(lcl->counters[i].prev,d);
+		LC_Move(lcl->counters[i].next,d);
+	}
+	lcl->base=lcl;
+}
+
+LCL_type * LCL_Clone(LCL_type * lcl)
+{
+	LCL_type * copy;
+
+	copy=(LCL_type *) LC_Alloc(1,lcl->bytes);
+	memcpy(copy,lcl,lcl->bytes);
+	LCL_Relocate(copy);
+	return copy;
 }
 
 void LCL_RebuildHash(LCL_type * lcl)
@@ -528,6 +682,7 @@ void LCL_RebuildHash(LCL_type * lcl)
 	// empty out the linked list
 	for (i=1; i<=lcl->size;i++) { // for each item in the data structure
 		pt=&lcl->counters[i];
+		if (pt->item==LCL_NULLITEM) continue; // unused counters are not hashed
 		pt->next=lcl->hashtable[lcl->counters[i].hash];
 		if (pt->next)
 			pt->next->prev=pt;
@@ -535,11 +690,65 @@ void LCL_RebuildHash(LCL_type * lcl)
 	}
 }
 
+void LCL_Rehash(LCL_type * lcl)
+{
+	// pick new hash function parameters and move every item to its new
+	// bucket.  Called when an update walks a chain longer than
+	// LCL_MAXCHAIN, which suggests that the items collide on purpose
+	int i;
+
+	lcl->hasha=prng_int(lcl->prng) & MOD;
+	lcl->hashb=prng_int(lcl->prng) & MOD;
+	for (i=1; i<=lcl->size;i++)
+		if (lcl->counters[i].item!=LCL_NULLITEM)
+			lcl->counters[i].hash=(int) hash31(lcl->hasha,lcl->hashb,
+				lcl->counters[i].item) % lcl->hashsize;
+	LCL_RebuildHash(lcl);
+	ST_EVENT(lcl->sc,ST_REHASH);
+}
+
+#ifdef LCL_HEAP_ARITY
+void Heapify(LCL_type * lcl, int ptr)
+{
+	// counter ptr has a new count: move its record down the d-ary heap.
+	// only the 8 byte records and their positions move, the counters
+	// (and so the hash chains) stay where they are
+	LCLHeapRec * heap=lcl->heap;
+	LCLHeapRec rec;
+	int pos, first, last, c, mc;
+	ST_EVENT(lcl->sc,ST_HEAPIFY);
+	ST_MARK(lcl->sc,ST_SIFT);
+
+	pos=lcl->heappos[ptr];
+	rec.count=lcl->counters[ptr].count;
+	rec.idx=ptr;
+	while (1)
+	{
+		first=LCL_HEAP_ARITY*pos+1;
+		if (first>=lcl->size) break; // no children
+		last=(first+LCL_HEAP_ARITY<lcl->size) ? first+LCL_HEAP_ARITY : lcl->size;
+		mc=first;
+		for (c=first+1;c<last;c++)
+			if (heap[c].count<heap[mc].count) mc=c;
+		if (rec.count<=heap[mc].count) break;
+		heap[pos]=heap[mc]; // move the smallest child up
+		lcl->heappos[heap[pos].idx]=pos;
+		pos=mc;
+		ST_EVENT(lcl->sc,ST_SIFT);
+	}
+	heap[pos]=rec;
+	lcl->heappos[ptr]=pos;
+	lcl->root=&lcl->counters[heap[0].idx];
+	ST_MAXSINCE(lcl->sc,maxsift,ST_SIFT);
+}
+#else
 void Heapify(LCL_type * lcl, int ptr)
 { // restore the heap condition in case it has been violated
 	LCLCounter tmp;
 	LCLCounter * cpt, *minchild;
 	int mc;
+	ST_EVENT(lcl->sc,ST_HEAPIFY);
+	ST_MARK(lcl->sc,ST_SIFT);
 
 	while(1)
 	{
@@ -559,10 +768,12 @@ void Heapify(LCL_type * lcl, int ptr)
 		*cpt=*minchild;
 		*minchild=tmp;
 		// else, swap the parent and child in the heap
+		ST_EVENT(lcl->sc,ST_SIFT);
 
-		if (cpt->hash==minchild->hash)
+		if (cpt->hash==minchild->hash && cpt->item!=LCL_NULLITEM
+			&& minchild->item!=LCL_NULLITEM)
 			// test if the hash value of a parent is the same as the 
-			// hash value of its child
+			// hash value of its child (unused counters are in no list)
 		{ 
 			// swap the prev and next pointers back. 
 			// if the two items are in the same linked list
@@ -581,8 +792,10 @@ void Heapify(LCL_type * lcl, int ptr)
 			if (cpt->next) 
 				cpt->next->prev=cpt; // place in linked list
 
-			if (!minchild->prev) // also fix up the child
-				lcl->hashtable[minchild->hash]=minchild; 
+			if (!minchild->prev) { // also fix up the child
+				if (minchild->item!=LCL_NULLITEM)
+					lcl->hashtable[minchild->hash]=minchild;
+			}
 			else
 				minchild->prev->next=minchild; 
 			if (minchild->next)
@@ -591,7 +804,9 @@ void Heapify(LCL_type * lcl, int ptr)
 		ptr=mc;
 		// continue on with the heapify from the child position
 	} 
+	ST_MAXSINCE(lcl->sc,maxsift,ST_SIFT);
 }
+#endif
 
 LCLCounter * LCL_FindItem(LCL_type * lcl, LCLitem_t item)
 { // find a particular item in the date structure and return a pointer to it
@@ -612,39 +827,73 @@ LCLCounter * LCL_FindItem(LCL_type * lcl, LCLitem_t item)
 	// returns NULL if we do not find the item
 }
 
-void LCL_Update(LCL_type * lcl, LCLitem_t item, LCLweight_t value)
+#ifdef LCL_PAYLOAD
+static inline void LCL_PayloadAdd(LCLPayload * agg, LCLvalue_t v)
 {
-	int hashval;
+	agg->sum+=v;
+	if (v<agg->min) agg->min=v;
+	if (v>agg->max) agg->max=v;
+}
+
+static inline void LCL_PayloadReset(LCLPayload * agg)
+{ // no values yet
+	agg->sum=0;
+	agg->min=INT64_MAX;
+	agg->max=INT64_MIN;
+}
+#endif
+
+static inline void LCL_UpdateHashed(LCL_type * lcl, LCLitem_t item,
+									LCLweight_t value, int hashval,
+									const LCLvalue_t * attr)
+{
+	// attr is the value for the payload, or NULL for none; without
+	// LCL_PAYLOAD it is always NULL, and compiled away
+	int chain;
 	LCLCounter * hashptr;
+	ST_START(lcl->sc);
 	// find whether new item is already stored, if so store it and add one
 	// update heap property if necessary
 
 	lcl->n+=value;
 	lcl->counters->item=0; // mark data structure as 'dirty'
 
-	hashval=(int) hash31(lcl->hasha, lcl->hashb,item) % lcl->hashsize;
 	hashptr=lcl->hashtable[hashval];
-	// compute the hash value of the item, and begin to look for it in 
-	// the hash table
+	// begin to look for the item in the hash table
+	ST_MARK(lcl->sc,ST_PROBE);
+	chain=0;
 
 	while (hashptr) {
+		ST_EVENT(lcl->sc,ST_PROBE);
+		chain++;
 		if (hashptr->item==item) {
+			ST_MAXSINCE(lcl->sc,maxchain,ST_PROBE);
 			hashptr->count+=value; // increment the count of the item
+#ifdef LCL_PAYLOAD
+			if (attr) LCL_PayloadAdd(&hashptr->agg,*attr);
+#endif
 			Heapify(lcl,hashptr-lcl->counters); // and fix up the heap
+			if (chain>LCL_MAXCHAIN) LCL_Rehash(lcl);
+			ST_STOP(lcl->stats);
 			return;
 		}
 		else hashptr=hashptr->next;
 	}
+	ST_MAXSINCE(lcl->sc,maxchain,ST_PROBE);
 	// if control reaches here, then we have failed to find the item
 	// so, overwrite smallest heap item and reheapify if necessary
-	// fix up linked list from hashtable
-	if (!lcl->root->prev) // if it is first in its list
-		lcl->hashtable[lcl->root->hash]=lcl->root->next;
-	else
-		lcl->root->prev->next=lcl->root->next;
-	if (lcl->root->next) // if it is not last in the list
-		lcl->root->next->prev=lcl->root->prev;
+	if (lcl->root->item!=LCL_NULLITEM) {
+		ST_EVENT(lcl->sc,ST_EVICT);
+		// fix up linked list from hashtable
+		if (!lcl->root->prev) // if it is first in its list
+			lcl->hashtable[lcl->root->hash]=lcl->root->next;
+		else
+			lcl->root->prev->next=lcl->root->next;
+		if (lcl->root->next) // if it is not last in the list
+			lcl->root->next->prev=lcl->root->prev;
+	}
 	// update the hash table appropriately to remove the old item
+	// (an unused counter is in no list)
 
 	// slot new item into hashtable
 	hashptr=lcl->hashtable[hashval];
@@ -661,14 +910,164 @@ void LCL_Update(LCL_type * lcl, LCLitem_t item, LCLweight_t value)
 	//  value+=lcl->root->delta;
 	// update the upper bound on the items frequency
 	lcl->root->count=value+lcl->root->delta;
-	Heapify(lcl,1); // restore heap property if needed
+#ifdef LCL_PAYLOAD
+	LCL_PayloadReset(&lcl->root->agg); // the payload starts afresh
+	if (attr) LCL_PayloadAdd(&lcl->root->agg,*attr);
+#else
+	(void) attr;
+#endif
+	Heapify(lcl,lcl->root-lcl->counters); // restore heap property if needed
 	// return value;
+	if (chain>LCL_MAXCHAIN) LCL_Rehash(lcl);
+	ST_STOP(lcl->stats);
+}
+
+void LCL_Update(LCL_type * lcl, LCLitem_t item, LCLweight_t value)
+{
+	LCL_UpdateHashed(lcl,item,value,
+		(int) hash31(lcl->hasha, lcl->hashb,item) % lcl->hashsize,NULL);
+}
+
+static inline void LCL_UpdateBatchHashed(LCL_type * lcl,
+	const LCLitem_t * items, const LCLweight_t * weights,
+	const LCLvalue_t * values, int n)
+{
+	// apply a batch of updates (weights may be NULL for all ones, values
+	// NULL for none), with the same result as calling LCL_Update (or
+	// LCL_UpdateValue) on each in turn.  A block of
+	// items is hashed at once; then, while item i is applied, the bucket
+	// head of item i+2*LCL_PREFETCH and the first counter in the chain
+	// of item i+LCL_PREFETCH are fetched, so that on summaries larger
+	// than the cache the two dependent loads of an update have already
+	// been issued by the time it is reached.
+	unsigned int hashes[LCL_BATCH];
+	int i, m, off, hasha, hashb;
+	LCLCounter * pt;
+
+	off=0;
+	while (off<n)
+	{
+		m=(n-off<LCL_BATCH) ? n-off : LCL_BATCH;
+		hasha=lcl->hasha;
+		hashb=lcl->hashb;
+		hash31_batch(hasha,hashb,items+off,hashes,m);
+		for (i=0;i<m;i++)
+		{
+			hashes[i]%=lcl->hashsize;
+			if (i<2*LCL_PREFETCH)
+				LCL_PREFETCHADDR(&lcl->hashtable[hashes[i]]);
+		}
+		for (i=0;i<m;)
+		{
+			if (i+2*LCL_PREFETCH<m)
+				LCL_PREFETCHADDR(&lcl->hashtable[hashes[i+2*LCL_PREFETCH]]);
+			if (i+LCL_PREFETCH<m)
+			{
+				pt=lcl->hashtable[hashes[i+LCL_PREFETCH]];
+				if (pt) LCL_PREFETCHADDR(pt);
+			}
+			LCL_UpdateHashed(lcl,items[off+i],(weights) ? weights[off+i] : 1,
+				hashes[i],(values) ? &values[off+i] : NULL);
+			i++;
+			if (lcl->hasha!=hasha || lcl->hashb!=hashb)
+				break; // the update caused a rehash: the other hashes are stale
+		}
+		off+=i;
+	}
+}
+
+void LCL_UpdateBatch(LCL_type * lcl, const LCLitem_t * items,
+					 const LCLweight_t * weights, int n)
+{
+	LCL_UpdateBatchHashed(lcl,items,weights,NULL,n);
+}
+
+#ifdef LCL_PAYLOAD
+void LCL_UpdateValue(LCL_type * lcl, LCLitem_t item, LCLweight_t value,
+	LCLvalue_t attr)
+{
+	LCL_UpdateHashed(lcl,item,value,
+		(int) hash31(lcl->hasha, lcl->hashb,item) % lcl->hashsize,&attr);
+}
+
+void LCL_UpdateBatchValues(LCL_type * lcl, const LCLitem_t * items,
+	const LCLweight_t * weights, const LCLvalue_t * values, int n)
+{
+	LCL_UpdateBatchHashed(lcl,items,weights,values,n);
+}
+#endif
+
+void LCL_UpdateBatchAggregate(LCL_type * lcl, const LCLitem_t * items,
+							  const LCLweight_t * weights, int n)
+{
+	// as LCL_UpdateBatch, but first collapse repeated items: each block
+	// of LCL_AGGBATCH updates is summed per distinct item in a small
+	// open addressing table (about 14KB, so it stays in L1), and only
+	// the (item, total) pairs reach the summary, in order of first
+	// appearance.  The summary differs from that of the updates one by
+	// one, but is that of a valid sequence of weighted updates with the
+	// same total, so the bound on the error still holds.  Items whose
+	// weights in a block sum to zero are dropped.
+	// Collapsing costs a few ns an update, while the repeats it saves
+	// are the cheapest updates, of heavy items already in cache.  So when
+	// a block turns out to be mostly distinct items, the next
+	// LCL_AGGSKIP blocks (in this call or later ones) go straight to
+	// LCL_UpdateBatch, and then another block is tried.
+	uint16_t slot[LCL_AGGSLOTS]; // 1+index into distinct[], or 0
+	uint16_t used[LCL_AGGBATCH]; // slots to clear after each block
+	LCLitem_t distinct[LCL_AGGBATCH];
+	LCLweight_t totals[LCL_AGGBATCH];
+	int i, j, d, m, off, h, clear;
+	LCLitem_t item;
+
+	clear=0;
+	for (off=0;off<n;off+=m)
+	{
+		m=(n-off<LCL_AGGBATCH) ? n-off : LCL_AGGBATCH;
+		if (lcl->aggskip>0)
+		{
+			lcl->aggskip--;
+			LCL_UpdateBatch(lcl,items+off,weights ? weights+off : NULL,m);
+			continue;
+		}
+		if (!clear)
+		{ // only if the call collapses anything
+			memset(slot,0,sizeof(slot));
+			clear=1;
+		}
+		d=0;
+		for (i=off;i<off+m;i++)
+		{
+			item=items[i];
+			h=(int) ((item*0x9E3779B1u)>>(32-LCL_AGGBITS));
+			while (slot[h] && distinct[slot[h]-1]!=item)
+				h=(h+1)&(LCL_AGGSLOTS-1);
+			if (!slot[h])
+			{
+				used[d]=(uint16_t) h;
+				distinct[d]=item;
+				totals[d]=0;
+				slot[h]=(uint16_t) ++d;
+			}
+			totals[slot[h]-1]+=(weights) ? weights[i] : 1;
+		}
+		for (i=0;i<d;i++)
+			slot[used[i]]=0;
+		if (d*LCL_AGGKEEP>m)
+			lcl->aggskip=LCL_AGGSKIP;
+		for (i=0,j=0;i<d;i++) // drop items that cancelled out
+			if (totals[i]!=0)
+			{
+				distinct[j]=distinct[i];
+				totals[j++]=totals[i];
+			}
+		LCL_UpdateBatch(lcl,distinct,totals,j);
+	}
 }
 
 int LCL_Size(LCL_type * lcl)
 { // return the size of the data structure in bytes
-	return sizeof(LCL_type) + (lcl->hashsize * sizeof(int)) + 
-		(lcl->size*sizeof(LCLCounter));
+	return (int) lcl->bytes;
 }
 
 LCLweight_t LCL_PointEst(LCL_type * lcl, LCLitem_t item)
@@ -691,6 +1090,31 @@ LCLweight_t LCL_PointErr(LCL_type * lcl, LCLitem_t item)
 		return lcl->root->delta;
 }
 
+#ifdef LCL_PAYLOAD
+int LCL_PointPayload(LCL_type * lcl, LCLitem_t item, LCLPayload * agg)
+{
+	LCLCounter * i;
+	i=LCL_FindItem(lcl,item);
+	if (!i)
+		return 0;
+	*agg=i->agg;
+	return 1;
+}
+
+std::map<uint32_t, LCLPayload> LCL_OutputPayload(LCL_type * lcl, int thresh)
+{
+	std::map<uint32_t, LCLPayload> res;
+
+	for (int i=1;i<=lcl->size;++i)
+	{
+		if (lcl->counters[i].count>=thresh && lcl->counters[i].count>0)
+			res.insert(std::pair<uint32_t, LCLPayload>(lcl->counters[i].item,
+				lcl->counters[i].agg));
+	}
+	return res;
+}
+
+#endif
 int LCL_cmp( const void * a, const void * b) {
 	LCLCounter * x = (LCLCounter*) a;
 	LCLCounter * y = (LCLCounter*) b;
@@ -703,6 +1127,9 @@ void LCL_Output(LCL_type * lcl) { // prepare for output
 	if (lcl->counters->item==0) {
 		qsort(&lcl->counters[1],lcl->size,sizeof(LCLCounter),LCL_cmp);
 		LCL_RebuildHash(lcl);
+#ifdef LCL_HEAP_ARITY
+		LCL_HeapBuild(lcl); // the counters have moved
+#endif
 		lcl->counters->item=1;
 	}
 }
@@ -720,6 +1147,89 @@ std::map<uint32_t, uint32_t> LCL_Output(LCL_type * lcl, int thresh)
 	return res;
 }
 
+static int LCL_cmpdown( const void * a, const void * b) {
+	return LCL_cmp(b,a);
+}
+
+void LCL_Merge(LCL_type * lcl, LCL_type * other)
+{
+	// fold other into lcl, as for mergeable summaries (Agarwal et al.,
+	// PODS 2012).  An item that one summary does not hold has a count of
+	// at most its least count, so it is given that as both count and
+	// error.  Of the items of both, the lcl->size largest counts are
+	// kept: every count is at least the sum of the two least counts,
+	// so the least count kept still bounds any item dropped
+	LCLCounter * all, * c;
+	LCLweight_t min1, min2;
+	int i, m, keep;
+
+	min1=lcl->root->count;
+	min2=other->root->count;
+	all=(LCLCounter *) malloc((lcl->size+other->size)*sizeof(LCLCounter));
+	if (!all)
+	{
+		fprintf(stderr,"Out of memory error in LCL_Merge\n");
+		exit(1);
+	}
+	m=0;
+	for (i=1;i<=lcl->size;i++)
+	{
+		if (lcl->counters[i].item==LCL_NULLITEM) continue;
+		all[m]=lcl->counters[i];
+		c=LCL_FindItem(other,all[m].item);
+		all[m].count+=(c) ? c->count : min2;
+		all[m].delta+=(c) ? c->delta : min2;
+#ifdef LCL_PAYLOAD
+		if (c)
+		{
+			all[m].agg.sum+=c->agg.sum;
+			if (c->agg.min<all[m].agg.min) all[m].agg.min=c->agg.min;
+			if (c->agg.max>all[m].agg.max) all[m].agg.max=c->agg.max;
+		}
+#endif
+		m++;
+	}
+	for (i=1;i<=other->size;i++)
+	{
+		c=&other->counters[i];
+		if (c->item==LCL_NULLITEM || LCL_FindItem(lcl,c->item)) continue;
+		all[m]=*c;
+		all[m].count+=min1;
+		all[m].delta+=min1;
+		m++;
+	}
+	qsort(all,m,sizeof(LCLCounter),LCL_cmpdown);
+
+	// the kept counters go in ascending order, after any unused ones,
+	// which makes the counters array a heap
+	keep=(m<lcl->size) ? m : lcl->size;
+	for (i=1;i<=lcl->size-keep;i++)
+	{
+		lcl->counters[i].item=LCL_NULLITEM;
+		lcl->counters[i].count=0;
+		lcl->counters[i].delta=0;
+	}
+	for (i=0;i<keep;i++)
+	{
+		c=&lcl->counters[lcl->size-i];
+		c->item=all[i].item;
+		c->count=all[i].count;
+		c->delta=all[i].delta;
+#ifdef LCL_PAYLOAD
+		c->agg=all[i].agg;
+#endif
+		c->hash=(int) hash31(lcl->hasha,lcl->hashb,c->item) % lcl->hashsize;
+	}
+	free(all);
+	LCL_RebuildHash(lcl);
+	lcl->root=&lcl->counters[1];
+#ifdef LCL_HEAP_ARITY
+	LCL_HeapBuild(lcl);
+#endif
+	lcl->counters->item=1; // sorted, as after LCL_Output
+	lcl->n+=other->n;
+}
+
 void LCL_CheckHash(LCL_type * lcl, int item, int hash)
 { // debugging routine to validate the hash table
 	int i;
@@ -788,11 +1298,12 @@ void LCL_ShowHeap(LCL_type * lcl)
 }
 
 /********************************************************************
-Implementation of Frequent algorithm to Find Frequent Items
-Based on papers by:
-Misra and Gries, 1982
-Demaine, Lopez-Ortiz, Munroe, 2002
-Karp, Papadimitriou and Shenker, 2003
+Implementation of Space Saving with unit increments
+Based on the paper of Metwally, Agrawal and El Abbadi, 2005
+Uses the Stream-Summary structure: items with equal counts share a
+group, and groups are kept in a list in increasing order of count,
+so that an increment moves an item to the next group in O(1) time.
+(The Frequent / Misra-Gries algorithm is in frequent.cc)
 Implementation by G. Cormode 2002, 2003
 
 Original Code: 2002-11
@@ -806,23 +1317,41 @@ to Creative Commons, 559 Nathan Abbott Way, Stanford, California
 *********************************************************************/
 
 LCU_type * LCU_Init(float fPhi)
+{ // hash functions are picked at random: see LCU_InitSeed
+	return LCU_InitSeed(fPhi,LC_RandomSeed());
+}
+
+LCU_type * LCU_InitSeed(float fPhi, int seed)
 {
 	int i;
 	int k = 1 + (int) 1.0/fPhi;
+	size_t prngoff, hashoff, groupoff, itemoff, freeoff, bytes;
 
-	LCU_type* result = (LCU_type*) calloc(1,sizeof(LCU_type));
-
-	result->a= (long long) 698124007;
-	result->b= (long long) 5125833;
 	if (k<1) k=1;
+	// one arena, as in LCL_InitSeed
+	prngoff=LC_Align(sizeof(LCU_type));
+	hashoff=prngoff+LC_Align(sizeof(prng_type));
+	groupoff=hashoff+LC_Align(LCU_HASHMULT*k*sizeof(LCUITEM *));
+	itemoff=groupoff+LC_Align(k*sizeof(LCUGROUP));
+	freeoff=itemoff+LC_Align(k*sizeof(LCUITEM));
+	bytes=freeoff+LC_Align(k*sizeof(LCUGROUP *));
+
+	LCU_type* result = (LCU_type*) LC_Alloc(1,bytes);
+	result->bytes=bytes;
+	result->base=result;
+
+	result->prng=(prng_type *) ((char *) result+prngoff);
+	LC_InitPrng(result->prng,seed);
+	result->a=prng_int(result->prng) & MOD;
+	result->b=prng_int(result->prng) & MOD;
 	result->k=k;
 	result->n=0;  
 
 	result->tblsz=LCU_HASHMULT*k;  
-	result->hashtable=(LCUITEM**) calloc(result->tblsz,sizeof(LCUITEM *));
-	result->groups=(LCUGROUP *)calloc(k,sizeof(LCUGROUP));
-	result->items=(LCUITEM *) calloc(k,sizeof(LCUITEM));
-	result->freegroups=(LCUGROUP **) calloc(k,sizeof(LCUGROUP*));
+	result->hashtable=(LCUITEM **) ((char *) result+hashoff);
+	result->groups=(LCUGROUP *) ((char *) result+groupoff);
+	result->items=(LCUITEM *) ((char *) result+itemoff);
+	result->freegroups=(LCUGROUP **) ((char *) result+freeoff);
 
 	for (i=0; i<result->tblsz;i++) 
 		result->hashtable[i]=NULL;
@@ -1010,20 +1539,48 @@ void LCU_IncrementCounter(LCU_type * lcu, LCUITEM *newi)
 	}
 }
 
+void LCU_Rehash(LCU_type * lcu) {
+	// pick new hash function parameters and move every monitored item
+	// to its new bucket, as LCL_Rehash
+	int i, h;
+	LCUITEM *il;
+
+	lcu->a=prng_int(lcu->prng) & MOD;
+	lcu->b=prng_int(lcu->prng) & MOD;
+	for (i=0; i<lcu->tblsz;i++)
+		lcu->hashtable[i]=NULL;
+	for (i=0; i<lcu->k;i++) {
+		il=&lcu->items[i];
+		il->nexti=NULL;
+		il->previousi=NULL;
+		if (il->parentg->count>0) { // counters still in the first
+			// group at zero are unused, and in no list
+			h=hash31(lcu->a,lcu->b,il->item) % lcu->tblsz;
+			LCU_InsertIntoHashtable(lcu,il,h,il->item);
+		}
+	}
+	ST_EVENT(lcu->sc,ST_REHASH);
+}
+
 void LCU_Update(LCU_type * lcu, int newitem) {
-	int h;
+	int h, chain;
 	LCUITEM *il;
+	ST_START(lcu->sc);
 
 	lcu->n++;
 	h=hash31(lcu->a,lcu->b,newitem) % lcu->tblsz;
 	il=lcu->hashtable[h];
+	chain=0;
 	while (il) {
+		chain++;
 		if (il->item ==newitem) 
 			break;
 		il=il->nexti;
 	}
 	if (il==NULL) // item is not monitored (not in hashtable) 
 	{
+		if (lcu->root->count>0) // every counter is in use
+			ST_EVENT(lcu->sc,ST_EVICT);
 		il=LCU_GetNewCounter(lcu);
 		/// and put it into the hashtable for the new item 
 		il->delta=lcu->root->count;
@@ -1036,18 +1593,62 @@ void LCU_Update(LCU_type * lcu, int newitem) {
 	else 
 		LCU_IncrementCounter(lcu, il);
 	// if we have an item, we need to increment its counter 
+	if (chain>LCU_MAXCHAIN) LCU_Rehash(lcu);
+	ST_STOP(lcu->stats);
 }
 
 int LCU_Size(LCU_type * lcu) {
-	return sizeof(LCU_type)+(lcu->tblsz)*sizeof(LCUITEM*) + 
-		(lcu->k)*(sizeof(LCUITEM) + sizeof(LCUGROUP) + sizeof(LCUITEM*));
+	return (int) lcu->bytes;
 }
 
 void LCU_Destroy(LCU_type * lcu)
 {
-	free(lcu->freegroups);
-	free(lcu->items);
-	free(lcu->groups);
-	free(lcu->hashtable);
-	free (lcu);
+	if (!lcu) return;
+	ST_FREE(lcu->stats);
+	free (lcu); // the generator and all arrays are in the same arena
+}
+
+void LCU_Relocate(LCU_type * lcu)
+{
+	// the arena has been copied from lcu->base: shift its pointers
+	ptrdiff_t d=(char *) lcu-(char *) lcu->base;
+	LCUITEM * il;
+	LCUGROUP * g;
+	int i;
+
+	ST_DETACH(lcu->stats);
+	if (d==0) return;
+	LC_Move(lcu->prng,d);
+	LC_Move(lcu->root,d);
+	LC_Move(lcu->hashtable,d);
+	LC_Move(lcu->groups,d);
+	LC_Move(lcu->items,d);
+	LC_Move(lcu->freegroups,d);
+	for (i=0;i<lcu->tblsz;i++)
+		LC_Move(lcu->hashtable[i],d);
+	for (i=0;i<lcu->k;i++)
+	{
+		LC_Move(lcu->freegroups[i],d);
+		g=&lcu->groups[i];
+		LC_Move(g->items,d);
+		LC_Move(g->previousg,d);
+		LC_Move(g->nextg,d);
+		il=&lcu->items[i];
+		LC_Move(il->parentg,d);
+		LC_Move(il->previousi,d);
+		LC_Move(il->nexti,d);
+		LC_Move(il->nexting,d);
+		LC_Move(il->previousing,d);
+	}
+	lcu->base=lcu;
+}
+
+LCU_type * LCU_Clone(LCU_type * lcu)
+{
+	LCU_type * copy;
+
+	copy=(LCU_type *) LC_Alloc(1,lcu->bytes);
+	memcpy(copy,lcu,lcu->bytes);
+	LCU_Relocate(copy);
+	return copy;
 }  
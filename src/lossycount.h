@@ -6,6 +6,7 @@
 #define LOSSYCOUNTING_h
 
 #include "prng.h"
+#include "stats.h"
 
 typedef struct lccounter
 {
@@ -23,6 +24,7 @@ typedef struct LC_type
   int maxholder;
   int window;
   int epoch;
+  ST_FIELD // timing and events, with SKETCH_STATS
 } LC_type;
 
 extern LC_type * LC_Init(float);
@@ -53,6 +55,7 @@ typedef struct LCD_type
   int maxholder;
   int window;
   int epoch;
+  ST_FIELD // timing and events, with SKETCH_STATS
 } LCD_type;
 
 extern LCD_type * LCD_Init(float);
@@ -74,6 +77,20 @@ extern std::map<uint32_t, uint32_t> LCD_Output(LCD_type *,int);
 
 #define LCLitem_t uint32_t
 
+//#define LCL_PAYLOAD // every counter also keeps the sum, least and
+// greatest of a value that comes with the updates of its item (such as
+// the bytes of a request), since the item was last given the counter.
+// If not defined, counters and updates are as without it
+#define LCLvalue_t int64_t
+
+#ifdef LCL_PAYLOAD
+typedef struct lclpayload_t
+{
+  LCLvalue_t sum; // of the values
+  LCLvalue_t min, max; // min>max if no update has come with a value
+} LCLPayload;
+#endif
+
 typedef struct lclcounter_t LCLCounter;
 
 struct lclcounter_t
@@ -83,22 +100,50 @@ struct lclcounter_t
   LCLweight_t count; // (upper bound on) count for the item
   LCLweight_t delta; // max possible error in count for the value
   LCLCounter *prev, *next; // pointers in doubly linked list for hashtable
+#ifdef LCL_PAYLOAD
+  LCLPayload agg; // 24 more bytes
+#endif
 }; // 32 bytes
 
 #define LCL_HASHMULT 3  // how big to make the hashtable of elements:
   // multiply 1/eps by this amount
   // about 3 seems to work well
+#define LCL_MAXCHAIN 16 // pick a new hash function if an update has to
+  // walk a longer chain than this
+#define LCL_BATCH 256 // items hashed together by LCL_UpdateBatch
+#define LCL_PREFETCH 8 // how many items ahead LCL_UpdateBatch fetches
+#define LCL_AGGBITS 11 // LCL_UpdateBatchAggregate sums blocks of
+#define LCL_AGGSLOTS (1<<LCL_AGGBITS) // LCL_AGGBATCH updates in a table
+#define LCL_AGGBATCH (LCL_AGGSLOTS/2) // with this many slots
+#define LCL_AGGKEEP 4 // a block with more than 1/LCL_AGGKEEP of its
+#define LCL_AGGSKIP 16 // items distinct stops collapsing for this many
 
 #ifdef LCL_SIZE
 #define LCL_SPACE (LCL_HASHMULT*LCL_SIZE)
 #endif
 
+//#define LCL_HEAP_ARITY 8 // 4 or 8: keep the heap as a separate d-ary heap
+// of small {count, counter} records, with the children of a node in one
+// cache line, instead of a binary heap of the counters themselves.
+// Counters then stay in place and a sift-down moves 8 bytes per level.
+// if not defined, the binary heap over 'counters' is used
+
+#ifdef LCL_HEAP_ARITY
+typedef struct lclheap_t
+{
+  LCLweight_t count; // copy of counters[idx].count
+  int idx; // the counter this record stands for
+} LCLHeapRec;
+#endif
+
 typedef struct LCL_type
 {
   LCLweight_t n;
   int hasha, hashb, hashsize;
   int size;
+  int aggskip; // blocks LCL_UpdateBatchAggregate passes on as they are
   LCLCounter *root;
+  prng_type *prng; // source of the hash parameters, also for rehashing
 #ifdef LCL_SIZE
   LCLCounter counters[LCL_SIZE+1]; // index from 1
   LCLCounter *hashtable[LCL_SPACE]; // array of pointers to items in 'counters'
@@ -109,15 +154,59 @@ typedef struct LCL_type
   LCLCounter *counters;
   LCLCounter ** hashtable; // array of pointers to items in 'counters'
 #endif
+#ifdef LCL_HEAP_ARITY
+  LCLHeapRec *heap; // heap[0] is the smallest, the children of heap[i]
+                    // are heap[d*i+1..d*i+d]; root is counters[heap[0].idx]
+  int *heappos;     // heappos[c] is the position of counter c in heap
+#endif
+  size_t bytes;     // everything above is in one allocation of this size,
+  void *base;       // which starts at this address (see LCL_Relocate)
+  ST_FIELD // timing and events, with SKETCH_STATS
 } LCL_type;
 
-extern LCL_type * LCL_Init(float fPhi);
+extern LCL_type * LCL_Init(float fPhi); // with a random seed
+extern LCL_type * LCL_InitSeed(float fPhi, int seed);
+// the same seed gives the same hash functions, and the same summary
 extern void LCL_Destroy(LCL_type *);
 extern void LCL_Update(LCL_type *, LCLitem_t, int);
+extern void LCL_UpdateBatch(LCL_type *, const LCLitem_t *,
+                            const LCLweight_t *, int);
+// items, weights (NULL for all ones), number of items
+extern void LCL_UpdateBatchAggregate(LCL_type *, const LCLitem_t *,
+                                     const LCLweight_t *, int);
+// the same, summing the weights of repeated items before they are applied
 extern int LCL_Size(LCL_type *);
 extern int LCL_PointEst(LCL_type *, LCLitem_t);
 extern int LCL_PointErr(LCL_type *, LCLitem_t);
+extern LCLCounter * LCL_FindItem(LCL_type *, LCLitem_t);
+// the counter of an item, or NULL if it has none.  With the binary heap,
+// counters move about as counts change: good until the next update
 extern std::map<uint32_t, uint32_t> LCL_Output(LCL_type *,int);
+#ifdef LCL_PAYLOAD
+extern void LCL_UpdateValue(LCL_type *, LCLitem_t, int, LCLvalue_t);
+// as LCL_Update, with a value for the payload of the item
+extern void LCL_UpdateBatchValues(LCL_type *, const LCLitem_t *,
+                                  const LCLweight_t *, const LCLvalue_t *,
+                                  int);
+// items, weights (NULL for all ones), values, number of items
+extern int LCL_PointPayload(LCL_type *, LCLitem_t, LCLPayload *);
+// the payload of an item: 0 if it has no counter
+extern std::map<uint32_t, LCLPayload> LCL_OutputPayload(LCL_type *, int);
+// the payloads of the items with a count of thresh or more
+#endif
+extern void LCL_Merge(LCL_type *, LCL_type *);
+// add the second summary into the first, which keeps its size; the
+// error of the result is at most that of one summary of both streams
+extern void LCL_Rehash(LCL_type *); // move to a new hash function
+extern LCL_type * LCL_Clone(LCL_type *); // a copy, with one memcpy
+extern void LCL_Relocate(LCL_type *);
+// a summary is the lcl->bytes bytes starting at lcl.  Once they have been
+// copied (or mapped from a file) to a new address, LCL_Relocate fixes up
+// the pointers inside, and the copy is ready to use.  Only a summary made
+// by LCL_Init or LCL_Clone is released with LCL_Destroy
+#define LCL_LAYOUT ((uint32_t) (sizeof(LCL_type)<<8 | sizeof(LCLCounter)))
+// differs between builds that lay out a summary differently (the heap,
+// the payload), so that an image is only read by a build that matches
 
 //////////////////////////////////////////////////////
 typedef int LCUWT;
@@ -126,6 +215,7 @@ typedef int LCUWT;
 //////////////////////////////////////////////////////
 
 #define LCU_HASHMULT 3
+#define LCU_MAXCHAIN 16 // rehash if an update walks a longer chain
 #ifdef LCU_SIZE
 #define LCU_TBLSIZE (LCU_HASHMULT*LCU_SIZE)
 #endif
@@ -160,6 +250,7 @@ typedef struct LCU_type{
   int k;
   int tblsz;
   long long a,b;
+  prng_type *prng; // source of a and b, also for rehashing
   LCUGROUP * root;
 #ifdef LCU_SIZE
   LCUITEM items[LCU_SIZE];
@@ -173,13 +264,25 @@ typedef struct LCU_type{
   LCUITEM **hashtable;
 
 #endif
-
+  size_t bytes; // everything above is in one allocation of this size,
+  void *base;   // which starts at this address (see LCU_Relocate)
+  ST_FIELD // timing and events, with SKETCH_STATS
 } LCU_type;
 
-extern LCU_type * LCU_Init(float fPhi);
+extern LCU_type * LCU_Init(float fPhi); // with a random seed
+extern LCU_type * LCU_InitSeed(float fPhi, int seed);
 extern void LCU_Destroy(LCU_type *);
 extern void LCU_Update(LCU_type *, int);
 extern int LCU_Size(LCU_type *);
 extern std::map<uint32_t, uint32_t> LCU_Output(LCU_type *,int);
+extern void LCU_Rehash(LCU_type *); // move to a new hash function
+extern LCU_type * LCU_Clone(LCU_type *); // a copy, with one memcpy
+extern void LCU_Relocate(LCU_type *); // as LCL_Relocate
+
+// shared by the summaries built on these (see lcldecay.h, lclhhh.h, ...)
+extern int LC_RandomSeed(); // a seed from the system, for the Init calls
+                            // that are not given one
+extern void * LC_Alloc(size_t n, size_t size);
+// n*size bytes, zeroed and aligned to a cache line; out of memory is fatal
 
 #endif
@@ -0,0 +1,354 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "persist.h"
+/********************************************************************
+Summaries kept in a file, with crash consistent checkpoints
+
+The file holds a header page and two checkpoint slots:
+
+  [ record 0 | record 1 ] [ slot 0 ] [ slot 1 ]
+
+The live summary is in anonymous memory, not in the file: a shared
+mapping would be written back by every sync of the slots, and each
+page written back is protected again, so the updates after a
+checkpoint would fault on every page they touch.  Summaries are laid
+out in one arena (see LCL_Relocate), so an image is just the bytes of
+the summary.  A checkpoint copies the live summary into a buffer,
+which is all that the updating thread waits for.  A
+flusher thread then writes the copy to slot epoch%2, syncs it, and only
+then writes record epoch%2, with a checksum of the image and of itself,
+and syncs again.  Whatever is torn by a crash, the record with the
+larger epoch whose checksums hold describes a complete image: on the
+next start that image is copied into the live summary, relocated, and
+used as it is.
+
+This work is licensed under the Creative Commons
+Attribution-NonCommercial License. To view a copy of this license,
+visit http://creativecommons.org/licenses/by-nc/1.0/ or send a letter
+to Creative Commons, 559 Nathan Abbott Way, Stanford, California
+94305, USA.
+*********************************************************************/
+
+uint64_t PS_Sum(const void * p, size_t n)
+{ // FNV-1a over 64 bit words; n is a multiple of 8
+	const uint64_t * w=(const uint64_t *) p;
+	uint64_t h=0xCBF29CE484222325ULL;
+	size_t i;
+
+	for (i=0;i<n/8;i++)
+	{
+		h^=w[i];
+		h*=0x100000001B3ULL;
+	}
+	return h;
+}
+
+void PS_MakeShape(PS_Shape * s, uint32_t magic, uint32_t version, int kind,
+	double param, int logu, size_t bytes)
+{
+	memset(s,0,sizeof(PS_Shape));
+	s->magic=magic;
+	s->version=version;
+	s->kind=kind;
+	s->structsize=(kind==PS_KINDLCL) ? LCL_LAYOUT : sizeof(QD_type);
+	s->param=param;
+	s->logu=logu;
+	s->bytes=bytes;
+}
+
+int PS_SameShape(const PS_Shape * a, const PS_Shape * b)
+{ // every field, since images hold raw structs and pointers of the build
+	return a->magic==b->magic && a->version==b->version &&
+		a->kind==b->kind && a->structsize==b->structsize &&
+		a->param==b->param && a->logu==b->logu && a->bytes==b->bytes;
+}
+
+static int PS_Write(int fd, const void * buf, size_t n, off_t off)
+{ // all of buf, or 0
+	const char * p=(const char *) buf;
+	ssize_t w;
+
+	while (n>0)
+	{
+		w=pwrite(fd,p,n,off);
+		if (w<0 && errno==EINTR) continue;
+		if (w<=0) return 0;
+		p+=w;
+		n-=w;
+		off+=w;
+	}
+	return 1;
+}
+
+static int PS_Read(int fd, void * buf, size_t n, off_t off)
+{ // all of buf, or 0
+	char * p=(char *) buf;
+	ssize_t r;
+
+	while (n>0)
+	{
+		r=pread(fd,p,n,off);
+		if (r<0 && errno==EINTR) continue;
+		if (r<=0) return 0;
+		p+=r;
+		n-=r;
+		off+=r;
+	}
+	return 1;
+}
+
+static inline off_t PS_SlotOffset(PS_type * ps, int slot)
+{
+	return PS_PAGE+(off_t) slot*ps->slotbytes;
+}
+
+static int PS_Store(PS_type * ps, const void * image, uint64_t epoch)
+{
+	// write image as checkpoint epoch, and return 1 once it is durable.
+	// The image first, then the record that points to it: a crash in
+	// between leaves the other record as the latest valid one
+	PS_Record r;
+	int slot;
+
+	r=ps->rec;
+	r.epoch=epoch;
+	slot=(int) (epoch%2);
+	r.imagesum=PS_Sum(image,ps->bytes);
+	r.recordsum=PS_Sum(&r,offsetof(PS_Record,recordsum));
+	return PS_Write(ps->fd,image,ps->bytes,PS_SlotOffset(ps,slot)) &&
+		fdatasync(ps->fd)==0 &&
+		PS_Write(ps->fd,&r,sizeof(r),slot*(PS_PAGE/2)) &&
+		fdatasync(ps->fd)==0;
+}
+
+static void PS_Flush(PS_type * ps)
+{
+	// the flusher thread: write out each checkpoint handed over in snap
+	std::unique_lock<std::mutex> l(ps->lock);
+	uint64_t epoch;
+	int ok;
+
+	while (1)
+	{
+		ps->wake.wait(l,[ps]{ return ps->pending || ps->stop; });
+		if (!ps->pending) break; // stopped, with nothing left to write
+		epoch=ps->epoch;
+		l.unlock();
+
+		ok=PS_Store(ps,ps->snap,epoch);
+
+		l.lock();
+		ps->pending=0;
+		if (ok) ps->durable=epoch;
+		else ps->failed=1;
+		ps->wake.notify_all();
+	}
+}
+
+static int PS_Valid(const PS_Record * r)
+{ // a complete record of this format
+	return r->shape.magic==PS_MAGIC && r->shape.version==PS_VERSION &&
+		r->recordsum==PS_Sum(r,offsetof(PS_Record,recordsum));
+}
+
+static PS_type * PS_Open(const char * path, const PS_Shape * shape,
+	const void * fresh)
+{
+	// open or create path for a summary of the given shape, and fill the
+	// live summary from the last good checkpoint, or else from fresh.
+	// The caller relocates the live summary
+	PS_type * ps;
+	PS_Record recs[2];
+	struct stat st;
+	int i, best, seen;
+	uint64_t last;
+
+	ps=new PS_type();
+	memset(&ps->rec,0,sizeof(PS_Record));
+	ps->rec.shape=*shape;
+	ps->kind=shape->kind;
+	ps->bytes=shape->bytes;
+	ps->slotbytes=(ps->bytes+PS_PAGE-1)/PS_PAGE*PS_PAGE;
+	ps->fd=open(path,O_RDWR|O_CREAT,0644);
+	if (ps->fd<0 || fstat(ps->fd,&st)!=0)
+	{
+		fprintf(stderr,"Error: cannot open %s: %s\n",path,strerror(errno));
+		if (ps->fd>=0) close(ps->fd);
+		delete ps;
+		return NULL;
+	}
+
+	// find the records of this file, if it has any
+	memset(recs,0,sizeof(recs));
+	seen=0;
+	best=-1;
+	last=0;
+	if (st.st_size>0)
+	{
+		for (i=0;i<2;i++)
+		{
+			if (!PS_Read(ps->fd,&recs[i],sizeof(PS_Record),i*(PS_PAGE/2)))
+				continue;
+			if (recs[i].shape.magic==PS_MAGIC) seen=1;
+			if (!PS_Valid(&recs[i])) continue;
+			if (!PS_SameShape(&recs[i].shape,shape))
+			{
+				fprintf(stderr,"Error: %s holds a different summary, or was "
+					"written by a different build\n",path);
+				close(ps->fd);
+				delete ps;
+				return NULL;
+			}
+			if (recs[i].epoch>last) last=recs[i].epoch;
+		}
+		if (!seen)
+		{ // not a file of ours: leave it alone
+			fprintf(stderr,"Error: %s is not a summary file\n",path);
+			close(ps->fd);
+			delete ps;
+			return NULL;
+		}
+	}
+
+	if (ftruncate(ps->fd,PS_PAGE+2*ps->slotbytes)!=0)
+	{
+		fprintf(stderr,"Error: cannot size %s: %s\n",path,strerror(errno));
+		close(ps->fd);
+		delete ps;
+		return NULL;
+	}
+	ps->live=(char *) mmap(NULL,ps->slotbytes,PROT_READ|PROT_WRITE,
+		MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+	ps->snap=(char *) aligned_alloc(64,ps->slotbytes);
+	if (ps->live==MAP_FAILED || !ps->snap)
+	{
+		fprintf(stderr,"Out of memory error mapping %s\n",path);
+		exit(1);
+	}
+	memset(ps->snap,0,ps->slotbytes); // fault it in now, not in a checkpoint
+
+	// the newest checkpoint whose image is intact, if any
+	for (i=0;i<2;i++)
+		if (PS_Valid(&recs[i]) && (best<0 || recs[i].epoch>recs[best].epoch))
+			best=i;
+	while (best>=0)
+	{
+		if (PS_Read(ps->fd,ps->live,ps->bytes,
+				PS_SlotOffset(ps,(int) (recs[best].epoch%2))) &&
+			PS_Sum(ps->live,ps->bytes)==recs[best].imagesum)
+			break;
+		recs[best].shape.magic=0; // torn: try the other one
+		best=(PS_Valid(&recs[1-best])) ? 1-best : -1;
+	}
+	if (best>=0)
+		ps->durable=recs[best].epoch;
+	else
+	{
+		// nothing to recover: start from fresh, and make it checkpoint 0
+		// at once, so that the file is known as ours even if we crash
+		// before the first checkpoint
+		memcpy(ps->live,fresh,ps->bytes);
+		ps->durable=0;
+		if (!PS_Store(ps,fresh,0))
+		{
+			fprintf(stderr,"Error: cannot write %s: %s\n",path,strerror(errno));
+			munmap(ps->live,ps->slotbytes);
+			free(ps->snap);
+			close(ps->fd);
+			delete ps;
+			return NULL;
+		}
+	}
+	ps->epoch=last; // so that new checkpoints are numbered after any seen
+	ps->flusher=std::thread(PS_Flush,ps);
+	return ps;
+}
+
+PS_type * PS_OpenLCL(const char * path, float fPhi)
+{
+	LCL_type * lcl;
+	PS_Shape shape;
+	PS_type * ps;
+
+	// a new summary gives the shape, and the contents for a new file
+	lcl=LCL_Init(fPhi);
+	PS_MakeShape(&shape,PS_MAGIC,PS_VERSION,PS_KINDLCL,fPhi,0,lcl->bytes);
+	ps=PS_Open(path,&shape,lcl);
+	if (ps) LCL_Relocate((LCL_type *) ps->live);
+	LCL_Destroy(lcl);
+	return ps;
+}
+
+PS_type * PS_OpenQD(const char * path, double eps, int logu)
+{
+	QD_type * qd;
+	PS_Shape shape;
+	PS_type * ps;
+
+	qd=QD_Init(eps,logu,-1);
+	PS_MakeShape(&shape,PS_MAGIC,PS_VERSION,PS_KINDQD,eps,logu,qd->bytes);
+	ps=PS_Open(path,&shape,qd);
+	if (ps) QD_Relocate((QD_type *) ps->live);
+	QD_Destroy(qd);
+	return ps;
+}
+
+LCL_type * PS_LCL(PS_type * ps)
+{
+	return (ps->kind==PS_KINDLCL) ? (LCL_type *) ps->live : NULL;
+}
+
+QD_type * PS_QD(PS_type * ps)
+{
+	return (ps->kind==PS_KINDQD) ? (QD_type *) ps->live : NULL;
+}
+
+int PS_Checkpoint(PS_type * ps)
+{
+	std::lock_guard<std::mutex> l(ps->lock);
+
+	if (ps->pending) return 0; // the flusher is still busy with snap
+	memcpy(ps->snap,ps->live,ps->bytes);
+	ps->epoch++;
+	ps->pending=1;
+	ps->wake.notify_one();
+	return 1;
+}
+
+int PS_Sync(PS_type * ps)
+{
+	std::unique_lock<std::mutex> l(ps->lock);
+
+	ps->wake.wait(l,[ps]{ return !ps->pending; });
+	return !ps->failed;
+}
+
+uint64_t PS_Epoch(PS_type * ps)
+{
+	std::lock_guard<std::mutex> l(ps->lock);
+	return ps->durable;
+}
+
+void PS_Close(PS_type * ps)
+{
+	if (!ps) return;
+	PS_Sync(ps);
+	PS_Checkpoint(ps);
+	{
+		std::lock_guard<std::mutex> l(ps->lock);
+		ps->stop=1;
+		ps->wake.notify_all();
+	}
+	ps->flusher.join(); // after the last checkpoint is written
+	munmap(ps->live,ps->slotbytes);
+	close(ps->fd);
+	free(ps->snap);
+	delete ps;
+}
@@ -0,0 +1,85 @@
+// persist.h -- header file for summaries kept in a file
+// an LCL summary or a q-digest lives in memory, with crash consistent
+// checkpoints in a file that are reused on the next start
+
+#ifndef PERSIST_h
+#define PERSIST_h
+
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "lossycount.h"
+#include "qdigest.h"
+
+#define PS_PAGE 4096 // the file is laid out in whole pages
+#define PS_MAGIC 0x5350434C // "LCPS"
+#define PS_VERSION 1
+
+enum { PS_KINDLCL=1, PS_KINDQD=2 }; // kinds of summary
+
+typedef struct ps_shape_t
+{ // what an image in a file is the image of: the start of each record
+  // here, and of each tile of a rollup (see rollup.h)
+  uint32_t magic;     // of the kind of file
+  uint32_t version;
+  uint32_t kind;      // PS_KINDLCL or PS_KINDQD
+  uint32_t structsize; // LCL_LAYOUT or sizeof(QD_type) of the build
+  double param;       // phi, or epsilon for a q-digest
+  int64_t logu;       // domain of a q-digest (0 for LCL)
+  uint64_t bytes;     // size of the summary image
+} PS_Shape;
+
+typedef struct ps_record_t
+{ // one checkpoint, as written to the header page of the file
+  PS_Shape shape;
+  uint64_t epoch;     // checkpoint number: the larger valid one wins
+  uint64_t imagesum;  // checksum of the image in slot epoch%2
+  uint64_t recordsum; // checksum of the fields above
+} PS_Record;
+
+typedef struct PS_type
+{
+  int kind;
+  int fd;
+  size_t bytes;     // size of the summary image
+  size_t slotbytes; // bytes rounded up to whole pages
+  char *live;       // the live summary, in anonymous memory
+  char *snap;       // copy of the summary waiting to be written
+  PS_Record rec;    // the fields common to every checkpoint of the file
+  uint64_t epoch;   // number of the last checkpoint taken
+  uint64_t durable; // number of the last checkpoint known to be on disk
+  int pending;      // snap holds a checkpoint not yet written
+  int stop;         // the flusher should finish
+  int failed;       // a write to the file has failed
+  std::mutex lock;  // guards pending, stop, durable and failed
+  std::condition_variable wake; // for the flusher, and for PS_Sync
+  std::thread flusher; // writes checkpoints out in the background
+} PS_type;
+
+extern PS_type * PS_OpenLCL(const char * path, float fPhi);
+extern PS_type * PS_OpenQD(const char * path, double eps, int logu);
+// open the summary kept in path, creating the file if it is new or holds
+// no valid checkpoint.  Otherwise the last valid checkpoint is reused as
+// it is, with nothing to replay.  Returns NULL if path holds a different
+// kind of summary, other parameters, or was made by a different build
+extern LCL_type * PS_LCL(PS_type *); // the live summary: update it as usual,
+extern QD_type * PS_QD(PS_type *);   // but do not destroy it
+extern int PS_Checkpoint(PS_type *);
+// take a checkpoint of the live summary, which is written to the file in
+// the background.  The caller is only held up for one copy of the
+// summary.  Returns 0, and does nothing, while the last one is still
+// being written
+extern int PS_Sync(PS_type *); // wait for the last checkpoint to be on disk;
+// returns 0 if a write failed
+extern uint64_t PS_Epoch(PS_type *); // the last checkpoint on disk
+extern void PS_Close(PS_type *); // take a last checkpoint, wait, and close
+
+extern uint64_t PS_Sum(const void *, size_t);
+// checksum of an image or a header; the size is a multiple of 8
+extern void PS_MakeShape(PS_Shape *, uint32_t magic, uint32_t version,
+                         int kind, double param, int logu, size_t bytes);
+// the shape of an image of bytes bytes, made by this build
+extern int PS_SameShape(const PS_Shape *, const PS_Shape *);
+// whether an image of one shape can be used where the other is expected
+
+#endif
@@ -3,6 +3,10 @@
 #include <stdlib.h>
 #include "prng.h"
 #include "rand48.h"
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define PRNG_SIMD
+#endif
 
 #define PI 3.141592653589793
 
@@ -129,6 +133,223 @@ long fourwise(int64_t a, int64_t b, int64_t c, int64_t d, int64_t x)
   return lresult;
 }
 
+/*************************************************************************/
+/* Batch versions of hash31 and fourwise, for blocks of 32 bit keys      */
+/*************************************************************************/
+
+// Every parameter is below 2^31 and every key below 2^32, so a*x+b
+// fits in 64 bits and is the product of two 32 bit values: this is
+// one vpmuludq per lane, 4 lanes to a register with AVX2 and 8 with
+// AVX-512.  The reduction is the same shift, add and mask as hash31,
+// so the results are identical to calling hash31 or fourwise per key.
+// The routine to use is picked on the first call from what the
+// processor supports.
+
+static inline uint32_t hash31_one(uint64_t a, uint64_t b, uint64_t x)
+{
+  uint64_t r=a*x+b;
+  return (uint32_t) (((r>>HL)+r) & MOD);
+}
+
+static void hash31_scalar(const uint32_t * p, const uint32_t * x,
+                          uint32_t * out, int n)
+{
+  int i;
+  for (i=0;i<n;i++)
+    out[i]=hash31_one(p[0],p[1],x[i]);
+}
+
+static void fourwise_scalar(const uint32_t * p, const uint32_t * x,
+                            uint32_t * out, int n)
+{
+  int i;
+  for (i=0;i<n;i++)
+    out[i]=hash31_one(hash31_one(hash31_one(p[0],p[1],x[i]),p[2],x[i]),
+                      p[3],x[i]);
+}
+
+#ifdef PRNG_SIMD
+__attribute__((target("avx2")))
+static inline __m256i hash31_avx2(__m256i a, __m256i b, __m256i x)
+{ // four lanes of hash31; a and x hold values below 2^32 in each lane
+  __m256i r=_mm256_add_epi64(_mm256_mul_epu32(a,x),b);
+  return _mm256_and_si256(_mm256_add_epi64(_mm256_srli_epi64(r,HL),r),
+                          _mm256_set1_epi64x(MOD));
+}
+
+__attribute__((target("avx2")))
+static inline void store_avx2(uint32_t * out, __m256i lo, __m256i hi)
+{ // pack the low halves of two sets of four 64 bit lanes into eight
+  const __m256i idx=_mm256_setr_epi32(0,2,4,6,1,3,5,7);
+  lo=_mm256_permutevar8x32_epi32(lo,idx);
+  hi=_mm256_permutevar8x32_epi32(hi,idx);
+  _mm256_storeu_si256((__m256i *) out,
+    _mm256_permute2x128_si256(lo,hi,0x20));
+}
+
+__attribute__((target("avx2")))
+static void hash31_avx2batch(const uint32_t * p, const uint32_t * x,
+                             uint32_t * out, int n)
+{
+  __m256i a, b, lo, hi;
+  int i;
+
+  a=_mm256_set1_epi64x(p[0]);
+  b=_mm256_set1_epi64x(p[1]);
+  for (i=0;i+8<=n;i+=8)
+    {
+      lo=_mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *) (x+i)));
+      hi=_mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *) (x+i+4)));
+      store_avx2(out+i,hash31_avx2(a,b,lo),hash31_avx2(a,b,hi));
+    }
+  hash31_scalar(p,x+i,out+i,n-i);
+}
+
+__attribute__((target("avx2")))
+static void fourwise_avx2batch(const uint32_t * p, const uint32_t * x,
+                               uint32_t * out, int n)
+{
+  __m256i a, b, c, d, lo, hi, hl, hh;
+  int i;
+
+  a=_mm256_set1_epi64x(p[0]);
+  b=_mm256_set1_epi64x(p[1]);
+  c=_mm256_set1_epi64x(p[2]);
+  d=_mm256_set1_epi64x(p[3]);
+  for (i=0;i+8<=n;i+=8)
+    {
+      lo=_mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *) (x+i)));
+      hi=_mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *) (x+i+4)));
+      hl=hash31_avx2(a,b,lo);
+      hh=hash31_avx2(a,b,hi);
+      hl=hash31_avx2(hl,c,lo);
+      hh=hash31_avx2(hh,c,hi);
+      store_avx2(out+i,hash31_avx2(hl,d,lo),hash31_avx2(hh,d,hi));
+    }
+  fourwise_scalar(p,x+i,out+i,n-i);
+}
+
+// GCC's _mm512_cvtepi64_epi32 starts from an undefined vector, which
+// -Wmaybe-uninitialized reports at every use
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f")))
+static inline __m512i hash31_avx512(__m512i a, __m512i b, __m512i x)
+{ // eight lanes of hash31
+  __m512i r=_mm512_add_epi64(_mm512_mul_epu32(a,x),b);
+  return _mm512_and_si512(_mm512_add_epi64(_mm512_srli_epi64(r,HL),r),
+                          _mm512_set1_epi64(MOD));
+}
+
+__attribute__((target("avx512f")))
+static void hash31_avx512batch(const uint32_t * p, const uint32_t * x,
+                               uint32_t * out, int n)
+{
+  __m512i a, b, lo, hi;
+  int i;
+
+  a=_mm512_set1_epi64(p[0]);
+  b=_mm512_set1_epi64(p[1]);
+  for (i=0;i+16<=n;i+=16)
+    {
+      lo=_mm512_cvtepu32_epi64(_mm256_loadu_si256((const __m256i *) (x+i)));
+      hi=_mm512_cvtepu32_epi64(_mm256_loadu_si256((const __m256i *) (x+i+8)));
+      _mm256_storeu_si256((__m256i *) (out+i),
+        _mm512_cvtepi64_epi32(hash31_avx512(a,b,lo)));
+      _mm256_storeu_si256((__m256i *) (out+i+8),
+        _mm512_cvtepi64_epi32(hash31_avx512(a,b,hi)));
+    }
+  hash31_scalar(p,x+i,out+i,n-i);
+}
+
+__attribute__((target("avx512f")))
+static void fourwise_avx512batch(const uint32_t * p, const uint32_t * x,
+                                 uint32_t * out, int n)
+{
+  __m512i a, b, c, d, lo, hi, hl, hh;
+  int i;
+
+  a=_mm512_set1_epi64(p[0]);
+  b=_mm512_set1_epi64(p[1]);
+  c=_mm512_set1_epi64(p[2]);
+  d=_mm512_set1_epi64(p[3]);
+  for (i=0;i+16<=n;i+=16)
+    {
+      lo=_mm512_cvtepu32_epi64(_mm256_loadu_si256((const __m256i *) (x+i)));
+      hi=_mm512_cvtepu32_epi64(_mm256_loadu_si256((const __m256i *) (x+i+8)));
+      hl=hash31_avx512(a,b,lo);
+      hh=hash31_avx512(a,b,hi);
+      hl=hash31_avx512(hl,c,lo);
+      hh=hash31_avx512(hh,c,hi);
+      _mm256_storeu_si256((__m256i *) (out+i),
+        _mm512_cvtepi64_epi32(hash31_avx512(hl,d,lo)));
+      _mm256_storeu_si256((__m256i *) (out+i+8),
+        _mm512_cvtepi64_epi32(hash31_avx512(hh,d,hi)));
+    }
+  fourwise_scalar(p,x+i,out+i,n-i);
+}
+#pragma GCC diagnostic pop
+#endif
+
+typedef void (*hash_batch_fn)(const uint32_t *, const uint32_t *,
+                              uint32_t *, int);
+typedef struct hash_batch_impl_t
+{
+  hash_batch_fn hash31, fourwise;
+} hash_batch_impl;
+
+static hash_batch_impl hash_batch_pick()
+{
+  hash_batch_impl impl={hash31_scalar,fourwise_scalar};
+#ifdef PRNG_SIMD
+  if (__builtin_cpu_supports("avx512f"))
+    {
+      impl.hash31=hash31_avx512batch;
+      impl.fourwise=fourwise_avx512batch;
+    }
+  else if (__builtin_cpu_supports("avx2"))
+    {
+      impl.hash31=hash31_avx2batch;
+      impl.fourwise=fourwise_avx2batch;
+    }
+#endif
+  return impl;
+}
+
+static const hash_batch_impl & hash_batch_select()
+{ // picked once, on the first call: the initialisation of a local
+  // static is thread safe, so callers on any thread agree
+  static const hash_batch_impl impl=hash_batch_pick();
+  return impl;
+}
+
+void hash31_batch(int64_t a, int64_t b, const uint32_t * x,
+                  uint32_t * out, int n)
+{
+  // out[i]=hash31(a,b,x[i]) for i<n
+  uint32_t p[2]={(uint32_t) a,(uint32_t) b};
+
+  hash_batch_select().hash31(p,x,out,n);
+}
+
+void fourwise_batch(int64_t a, int64_t b, int64_t c, int64_t d,
+                    const uint32_t * x, uint32_t * out, int n)
+{
+  // out[i]=fourwise(a,b,c,d,x[i]) for i<n
+  uint32_t p[4]={(uint32_t) a,(uint32_t) b,(uint32_t) c,(uint32_t) d};
+
+  hash_batch_select().fourwise(p,x,out,n);
+}
+
+const char * hash_batch_isa()
+{ // which of the routines above is in use
+#ifdef PRNG_SIMD
+  if (hash_batch_select().hash31==hash31_avx512batch) return "avx512";
+  if (hash_batch_select().hash31==hash31_avx2batch) return "avx2";
+#endif
+  return "scalar";
+}
+
 
 /*************************************************************************/
 /* First, some pseudo-random number generators sourced from other places */
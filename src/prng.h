@@ -43,6 +43,12 @@ typedef unsigned __int64 uint64_t;
 
 extern long hash31(int64_t, int64_t, int64_t);
 extern long fourwise(int64_t, int64_t, int64_t, int64_t, int64_t);
+extern void hash31_batch(int64_t, int64_t, const uint32_t *, uint32_t *, int);
+extern void fourwise_batch(int64_t, int64_t, int64_t, int64_t,
+                           const uint32_t *, uint32_t *, int);
+// hash31 and fourwise of n 32 bit keys at once (with AVX2 or AVX-512
+// when the processor has them); parameters must be below 2^31
+extern const char * hash_batch_isa(); // "avx512", "avx2" or "scalar"
 
 #define KK  17
 #define NTAB 32
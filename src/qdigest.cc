@@ -4,6 +4,7 @@
 // implemented slow insert procedure: start at root
 // alternate fast insert procedure: hash map -- not implemented
 
+#include <string.h>
 #include "qdigest.h"
 
 #define QDBFFLAG 1
@@ -159,22 +160,130 @@ QD_admin * QD_InitAdmin(double eps, int logu) {
 	return qda;
 }
 
-QD_type * QD_Init(double eps, int logu, int freel) {
-	// Initialize the data structure
+static size_t QD_Align(size_t n)
+{ // round up to a whole number of cache lines
+	return (n+63) & ~((size_t) 63);
+}
 
-	QD_type* qd=(QD_type *) calloc(1,sizeof(QD_type));
+QD_type * QD_Init(double eps, int logu, int freel) {
+	// Initialize the data structure: the struct, the admin, the nodes and
+	// the free list all go in one arena, so that the digest can be copied
+	// with memcpy and put right with QD_Relocate
+	QD_admin * qda;
+	QD_type * qd;
+	size_t adminoff, nodeoff, freeoff, bytes;
+	int i;
 
-	qd->a=QD_InitAdmin(eps,logu);
+	qda=QD_InitAdmin(eps,logu);
 	if (freel>=0) 
-		qd->a->size=freel; // overwrite the computed size if instructured
-	QD_FreeListInit(qd,1);  // also sets all nodes to zero.
+		qda->size=freel; // overwrite the computed size if instructured
+	adminoff=QD_Align(sizeof(QD_type));
+	nodeoff=adminoff+QD_Align(sizeof(QD_admin));
+	freeoff=nodeoff;
+	if (qda->size>0) // no nodes if they will be shared (QD_ListShare)
+		freeoff+=QD_Align((1+qda->size)*sizeof(QD_node));
+	bytes=freeoff;
+	if (qda->size>0)
+		bytes+=QD_Align((1+qda->size)*sizeof(QD_node*));
+
+	qd=(QD_type *) aligned_alloc(64,bytes);
+	if (!qd) {
+		fprintf(stderr,"Out of memory error allocating %d items\n", qda->size);
+		exit (1);
+	}
+	memset(qd,0,bytes); // also sets all nodes to zero.
+	qd->bytes=bytes;
+	qd->base=qd;
+	qd->a=(QD_admin *) ((char *) qd+adminoff);
+	*qd->a=*qda;
+	free(qda);
+	qda=qd->a;
+	if (qda->size>0) {
+		qd->q=(QD_node *) ((char *) qd+nodeoff);
+		qda->freelist=(QD_node **) ((char *) qd+freeoff);
+		for (i=0; i<qda->size; i++)
+			qda->freelist[i]=&qd->q[i];
+		qda->freelist[qda->size]=NULL; // put a null pointer at end of list
+		qda->freep=0; // integer index into freelist
+		qda->freept=&qda->freep; // use a pointer to allow sharing
+	}
 	return qd;
 }
 
+static void QD_RelocateR(QD_node * point, ptrdiff_t d){
+	// shift the child pointers of a subtree that has moved by d bytes
+	int i;
+
+	for (i=0;i<=1;i++)
+		if (point->kids[i]) {
+			point->kids[i]=(QD_node *) ((char *) point->kids[i]+d);
+			QD_RelocateR(point->kids[i],d);
+		}
+}
+
+void QD_Relocate(QD_type * qd){
+	// the arena has been copied from qd->base: shift its pointers.  Only
+	// the nodes in the tree and in the buffer hold live pointers (and a
+	// buffer node keeps its item in kids[0]); free nodes are cleaned
+	// before they are used again
+	ptrdiff_t d=(char *) qd-(char *) qd->base;
+	QD_admin * qda;
+	QD_node * pt;
+	int i;
+
+	ST_DETACH(qd->stats);
+	if (d==0) return;
+	qd->a=(QD_admin *) ((char *) qd->a+d);
+	qda=qd->a;
+	if (qda->freept!=(int *) ((char *) &qda->freep-d)) {
+		fprintf(stderr,"Error: a digest sharing nodes cannot be relocated\n");
+		exit(1);
+	}
+	qda->freept=&qda->freep;
+	if (qd->q) qd->q=(QD_node *) ((char *) qd->q+d);
+	if (qda->freelist) {
+		qda->freelist=(QD_node **) ((char *) qda->freelist+d);
+		for (i=0;i<=qda->size;i++)
+			if (qda->freelist[i])
+				qda->freelist[i]=(QD_node *) ((char *) qda->freelist[i]+d);
+	}
+	if (qda->qhead) {
+		qda->qhead=(QD_node *) ((char *) qda->qhead+d);
+		QD_RelocateR(qda->qhead,d);
+	}
+	if (qda->bufhead) {
+		qda->bufhead=(QD_node *) ((char *) qda->bufhead+d);
+		for (pt=qda->bufhead;pt->kids[1];pt=pt->kids[1])
+			pt->kids[1]=(QD_node *) ((char *) pt->kids[1]+d);
+	}
+	qd->base=qd;
+}
+
+QD_type * QD_Clone(QD_type * qd){
+	QD_type * copy;
+
+	if (!qd->bytes || qd->a->freept!=&qd->a->freep) {
+		fprintf(stderr,"Error: only a digest with its own nodes can be cloned\n");
+		exit(1);
+	}
+	copy=(QD_type *) aligned_alloc(64,qd->bytes);
+	if (!copy) {
+		fprintf(stderr,"Out of memory error allocating %zu bytes\n",qd->bytes);
+		exit (1);
+	}
+	memcpy(copy,qd,qd->bytes);
+	QD_Relocate(copy);
+	return copy;
+}
+
 void QD_Destroy(QD_type * qd){
 	// remove freelist, and self
 
-	if (qd) {
+	if (qd && qd->bytes) { // made by QD_Init: everything is in one arena
+		ST_FREE(qd->stats);
+		free(qd);
+	}
+	else if (qd) {
 		if (qd->a->freelist){
 			free(qd->a->freelist);
 			qd->a->freelist=NULL;
@@ -184,6 +293,7 @@ void QD_Destroy(QD_type * qd){
 			qd->q=NULL;
 		}
 		free(qd->a);
+		ST_FREE(qd->stats);
 		free (qd);
 	}
 }
@@ -241,7 +351,7 @@ QD_node * QD_KillKids(QD_admin * qda, QD_node * q) {
 	int i;
 
 	for (i=0; i<=1; i++)
-		if (q->kids[i]>0)
+		if (q->kids[i])
 			q->kids[i]=QD_KillKids(qda,q->kids[i]);
 	QD_RemoveNode(qda,q);
 	q->count=0;
@@ -335,13 +445,15 @@ void QD_InsertR(QD_admin * qda, size_t item, QDWeight_t weight) {
 	}
 }
 
+static void QD_InsertOne(QD_type *, size_t, QDWeight_t);
+
 void QD_MergeBuf(QD_type * fqd, QD_type * qd) {
 	// merge when qd is buffering:
 	//  use insert routine to insert buffered items into fqd
 	QD_node *pt;
 	while (qd->a->bufhead) {
 		pt=QD_UnBuffer(qd);
-		QD_Insert(fqd,(size_t) pt->kids[0],pt->wt);
+		QD_InsertOne(fqd,(size_t) pt->kids[0],pt->wt);
 		// retrieve stuffed data from buffer
 	}
 }
@@ -351,12 +463,14 @@ void QD_ConvertFromBuffer(QD_type * qd) {
 
 	if (qd->a->flags&QDBFFLAG) { // check that it is buffering
 		qd->a->thresh=qd->a->n/qd->a->slack;
+		if (qd->a->thresh<1) // after a merge this can come a little early:
+			qd->a->thresh=1; // a threshold of 0 would need a whole path per item
 		qd->a->flags-=QDBFFLAG; // indicate no longer buffering
 		QD_MergeBuf(qd,qd);
 	}
 }
 
-void QD_Insert(QD_type * qd, size_t item, QDWeight_t wt) {
+static void QD_InsertOne(QD_type * qd, size_t item, QDWeight_t wt) {
 	// try to insert at node
 	// if count >= thresh
 	// got to appropriate child
@@ -368,10 +482,13 @@ void QD_Insert(QD_type * qd, size_t item, QDWeight_t wt) {
 	qda->_new--;
 	if (qda->_new==0) {
 		// if it is time to update the threshold
-		if (qda->bufhead)  // if we are buffering
+		if (qda->bufhead) { // if we are buffering
+			ST_EVENT(qd->sc,ST_UNBUFFER);
 			QD_ConvertFromBuffer(qd);
-		else
+		} else {
+			ST_EVENT(qd->sc,ST_COMPRESS);
 			QD_Compress(qd);
+		}
 		qda->_new=qda->slack;
 	}
 	if (qda->flags & QDBFFLAG) // insert into buffer if flags is set
@@ -379,12 +496,22 @@ void QD_Insert(QD_type * qd, size_t item, QDWeight_t wt) {
 	else {
 		QD_InsertR(qda,item,wt);
 		qda->flags|=QDWTFLAG; // indicate we have touched the structure
-		if (qda->qdsize>qda->size-100) // hard code constant 100
+		if (qda->qdsize>qda->size-100) { // hard code constant 100
+			ST_EVENT(qd->sc,ST_COMPRESS);
 			QD_Compress(qd);
+		}
 		// if data structure is getting dangerously full, compress
 	}
 }
 
+void QD_Insert(QD_type * qd, size_t item, QDWeight_t wt) {
+	// the internal routines (merging, the 2D digests) call QD_InsertOne,
+	// so that only the caller's own inserts are timed
+	ST_START(qd->sc);
+	QD_InsertOne(qd,item,wt);
+	ST_STOP(qd->stats);
+}
+
 void QD_Reset(QD_admin * qda) {
 	// reset a qdidgest: remove all children, set root to zero, reset values
 	if (qda->qhead)
@@ -392,6 +519,14 @@ void QD_Reset(QD_admin * qda) {
 	QD_DefaultVals(qda);
 }
 
+void QD_Clear(QD_type * qd) {
+	// empty a digest for reuse, giving its nodes (tree and buffer) back to
+	// the free list, which may be shared
+	while (qd->a->bufhead)
+		QD_UnBuffer(qd);
+	QD_Reset(qd->a);
+}
+
 void QD_Copy(QD_type * fqd, QD_node *fpt, QD_node*pt, int c, int depth){
 	// if nodes exist in qd but not in fqd, copy them
 	// create new node, link to parent
@@ -423,19 +558,6 @@ void QD_MergeR(QD_type * fqd, QD_node *fpt, QD_node *pt, int depth) {
 		}
 }
 
-void QD_Swap(QD_type * fqd, QD_type * qd) {
-	// swap over two data structure
-	//   (which is not too hard, since they are pointer based)
-	QD_type tmp;
-
-	tmp.a=fqd->a;
-	tmp.q=fqd->q;
-	fqd->a=qd->a;
-	fqd->q=qd->q;
-	qd->a=tmp.a;
-	qd->q=tmp.q;
-}
-
 void QD_SetThresh(QD_admin * qda) {
 	// after a merge, recompute the threshold based on the current count n
 	qda->thresh=qda->n/qda->slack;
@@ -444,23 +566,24 @@ void QD_SetThresh(QD_admin * qda) {
 
 void QD_Merge(QD_type * fqd, QD_type * qd) {
 	// logic: if qd is buffering, insert whole buffer into fqd
-	// if fqd is buffering, and qd is not, do reverse and then copy
+	// if fqd is buffering, and qd is not, convert fqd and then copy
 
 	QD_Compress(fqd);
 	QD_Compress(qd);
 
 	if (qd->a->bufhead) // if buffering first
 		QD_MergeBuf(fqd,qd);
-	else
-		if (fqd->a->bufhead) { // if buffering second
-			QD_MergeBuf(qd,fqd);
-			QD_Swap(qd,fqd);
-		} else {
-			QD_MergeR(fqd, fqd->a->qhead, qd->a->qhead, qd->a->logu);
-		}
-		QD_Reset(qd->a);
-		QD_SetThresh(fqd->a);
-		QD_Compress(fqd);
+	else if (qd->a->qhead) {
+		// if buffering second, build its tree first: each digest keeps
+		// its own nodes, so they cannot be swapped over
+		QD_ConvertFromBuffer(fqd);
+		if (!fqd->a->qhead)
+			fqd->a->qhead=QD_CleanNode(QD_GetNode(fqd->a));
+		QD_MergeR(fqd, fqd->a->qhead, qd->a->qhead, qd->a->logu);
+	}
+	QD_Reset(qd->a);
+	QD_SetThresh(fqd->a);
+	QD_Compress(fqd);
 }
 
 /*************************************/
@@ -563,6 +686,7 @@ unsigned int QD_OutputQuantile(QD_type * qd, double phi) {
 	}
 	id=0;
 	point=qd->a->qhead;
+	if (!point) return 0; // nothing inserted yet
 	thresh=(QDWeight_t) (phi*qd->a->n);
 	// compute the weight we are looking for
 	for (depth=qd->a->logu-1; depth>0; depth--) {
@@ -582,6 +706,15 @@ unsigned int QD_OutputQuantile(QD_type * qd, double phi) {
 	return id;
 }
 
+void QD_OutputQuantiles(QD_type * qd, const double * phis, int n,
+						unsigned int * out) {
+	// answer a batch of quantile queries; the buffer is converted and the
+	// weights recomputed (at most) once, by the first query
+	int i;
+	for (i=0; i<n; i++)
+		out[i]=QD_OutputQuantile(qd,phis[i]);
+}
+
 QDWeight_t QD_OutputWeight(QD_type * qd, int item) {
 	// estimate the weight of a given item
 	QD_node * point;
@@ -759,15 +892,16 @@ QD2_type * QD2_Init(double eps, int logu, int logw, int maxn, int eager){
 void QD2_Destroy(QD2_type * qd){
 	int i;
 
-	// kill the shared secondary qd nodes
-	QD_Destroy(qd->q[0].qd);
-	// remove the other secondary qds
+	// remove the secondary qds, then the one whose nodes they share
 	for (i=1; i<=qd->a->size;i++){
-		free(qd->q[i].qd);
+		QD_Destroy(qd->q[i].qd);
 	}
-	// remove the primary qd nodes
-	// remove the primary qd
-	QD_Destroy((QD_type *) qd);
+	QD_Destroy(qd->q[0].qd);
+	// remove the primary qd nodes, its free list, and the primary qd
+	free(qd->a->freelist);
+	free(qd->q);
+	free(qd->a);
+	free(qd);
 }
 
 QD2_node* QD2_KillKids(QD2_type * qd, QD_type * dest, QD2_node *point) {
@@ -947,11 +1081,11 @@ void QD2_InsertR(QD2_type * qd, unsigned int xitem, unsigned int yitem) {
 		if (point->count<thresh || i==0) { 
 			// if there is room at current node, or have reached leaf, insert
 			point->count++;
-			QD_Insert(point->qd,yitem,1);
+			QD_InsertOne(point->qd,yitem,1);
 			break;
 		} else { // use mask to probe bit value
 			if (qd->a->eager==1) // in eager merge, also insert here
-				QD_Insert(point->qd,yitem,1);
+				QD_InsertOne(point->qd,yitem,1);
 			b=((xitem&mask)==0)?0:1;
 			if (point->kids[b]==0) // create child if not already there
 				QD_CreateNode(qd->a,(QD_node *) point,b); // some pointer casting
@@ -1029,6 +1163,7 @@ void QDSW_Destroy(QDSW_type * sw){
 	int i;
 	for (i=0;i<sw->n;i++)
 		QD2_Destroy(sw->qds[i]);
+	ST_FREE(sw->stats);
 	free(sw);
 }
 
@@ -1044,6 +1179,7 @@ int dcmp(const void *x, const void *y) {
 
 void QDSW_Insert(QDSW_type * sw, size_t item, unsigned int time){
 	int i,j;
+	ST_START(sw->sc);
 
 	sw->i++;
 	sw->bufpt--;
@@ -1051,6 +1187,7 @@ void QDSW_Insert(QDSW_type * sw, size_t item, unsigned int time){
 	sw->buffer[sw->bufpt][1]=item;
 
 	if (sw->bufpt<=0) {
+		ST_EVENT(sw->sc,ST_SORT);
 		qsort(sw->buffer,sw->bufsize,sizeof(duo),dcmp);
 		//sort buffer on reverse time
 		sw->bufpt=sw->bufsize/6;
@@ -1060,6 +1197,7 @@ void QDSW_Insert(QDSW_type * sw, size_t item, unsigned int time){
 				QD2_Insert(sw->qds[i],sw->buffer[j][0],sw->buffer[j][1]);
 		}
 	}
+	ST_STOP(sw->stats);
 }
 
 void QDSW_Compress(QDSW_type * sw){
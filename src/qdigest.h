@@ -2,6 +2,7 @@
 #define QDIGEST_h
 
 #include "prng.h"
+#include "stats.h"
 
 #define QDWeight_t int
 #define QDTime_t double
@@ -61,6 +62,9 @@ typedef struct QD_type{
 #else
   QD_node * q;
 #endif
+  ST_FIELD // timing and events of QD_Insert, with SKETCH_STATS
+  size_t bytes; // QD_Init puts the digest in one allocation of this size,
+  void *base;   // which starts at this address (see QD_Relocate)
 } QD_type;
 
 extern QD_type * QD_Init(double, int, int);  
@@ -70,6 +74,8 @@ extern void QD_InsertDecayed(QD_type *, size_t, double);
 extern void QD_Compress(QD_type *); // Compress
 extern void QD_CompressDecay(QD_type *); 
 extern unsigned int QD_OutputQuantile(QD_type *, double);
+extern void QD_OutputQuantiles(QD_type *, const double *, int, unsigned int *);
+// answer a batch of quantile queries phis[0..n-1] into out[0..n-1]
 extern void QD_Destroy(QD_type *); // Destroy
 extern std::map<uint32_t, uint32_t> QD_FindHH(QD_type *, int);
 // returns a list of heavy hitters above threshold
@@ -78,7 +84,15 @@ extern int QD_Size(QD_type *);  // output size of structure (in bytes)
 extern int QD_Nodes(QD_type *);  // output size of structure (in nodes)
 extern void QD_Merge(QD_type *, QD_type *);
 
+extern QD_type * QD_Clone(QD_type *); // a copy, with one memcpy
+extern void QD_Relocate(QD_type *);
+// a digest is the qd->bytes bytes starting at qd: once they have been
+// copied (or mapped from a file) to a new address, QD_Relocate fixes up
+// the pointers inside.  Not for digests that share nodes (QD_ListShare)
+
 extern void QD_ListShare(QD_type *, QD_type *); 
+extern void QD_Clear(QD_type *);
+// empty a digest, and return its nodes to the (maybe shared) free list
 //extern void QD_Show(QD_type *, unsigned int, QD_node*, int);
 // (debugging) show contents of data structure
 
@@ -119,6 +133,7 @@ typedef struct QDSW_type{
   QD2_type ** qds;
   duo * buffer;
   int n, i, bufsize, bufpt;
+  ST_FIELD // timing and events, with SKETCH_STATS
 } QDSW_type;
 
 extern QDSW_type * QDSW_Init(double, int, int, int, int);
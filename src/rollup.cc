@@ -0,0 +1,473 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <vector>
+#include "rollup.h"
+/********************************************************************
+Time tiered rollups of LCL summaries and q-digests
+
+Time is cut into base intervals of a fixed width, and each interval
+gets a summary of its own: the open one is updated in memory.  When
+time moves on, the closed summary is handed to a background thread,
+which writes it as a tile of tier 0.  A tile of tier i covers
+factors[i-1] tiles of tier i-1; once the last base interval it covers
+has gone by, the thread merges its children (LCL_Merge or QD_Merge) and
+writes the result as a tile of its own.  Tiles are kept one per file,
+as a header and the image of the summary (see LCL_Relocate), so that
+reading a tile is one read and a relocation.
+
+A query over [t1,t2) walks the range from the left, and takes at each
+step the coarsest tile that starts there, lies inside the range, and
+has been written; otherwise the base tile.  A day of minutes in hour
+tiles is then at most 23 hours and 2*59 minutes, and a day aligned to
+days is one tile.  The open interval, and closed ones the thread has
+not written yet, are taken from memory.  Tiles that are missing (say
+the thread is behind, or nothing happened in an hour) are covered by
+their children, so an answer never depends on the rollups being done.
+
+The directory also holds a file 'rollup' with the shape of the tiles
+and the open interval, so that tiles of another shape are not mixed
+in, and a restart picks up the open interval where it was left.
+
+This work is licensed under the Creative Commons
+Attribution-NonCommercial License. To view a copy of this license,
+visit http://creativecommons.org/licenses/by-nc/1.0/ or send a letter
+to Creative Commons, 559 Nathan Abbott Way, Stanford, California
+94305, USA.
+*********************************************************************/
+
+static void RU_Path(RU_type * ru, int tier, int64_t index, char * path,
+	size_t n)
+{
+	snprintf(path,n,"%s/%d-%lld.tile",ru->dir,tier,(long long) index);
+}
+
+/////////////////////////////////////////////////////////////////////
+// the few operations that differ between the kinds of summary
+
+static void * RU_Fresh(RU_type * ru)
+{
+	if (ru->kind==PS_KINDLCL)
+		return LCL_Init((float) ru->param);
+	return QD_Init(ru->param,ru->logu,-1);
+}
+
+static size_t RU_Bytes(RU_type * ru, void * s)
+{
+	return (ru->kind==PS_KINDLCL) ? ((LCL_type *) s)->bytes :
+		((QD_type *) s)->bytes;
+}
+
+static void * RU_Clone(RU_type * ru, void * s)
+{
+	if (ru->kind==PS_KINDLCL)
+		return LCL_Clone((LCL_type *) s);
+	return QD_Clone((QD_type *) s);
+}
+
+static void RU_Destroy(RU_type * ru, void * s)
+{
+	if (ru->kind==PS_KINDLCL)
+		LCL_Destroy((LCL_type *) s);
+	else
+		QD_Destroy((QD_type *) s);
+}
+
+static void RU_Merge(RU_type * ru, void * acc, void * s)
+{ // add s into acc; s is destroyed
+	if (ru->kind==PS_KINDLCL)
+		LCL_Merge((LCL_type *) acc,(LCL_type *) s);
+	else
+		QD_Merge((QD_type *) acc,(QD_type *) s);
+	RU_Destroy(ru,s);
+}
+
+static void RU_Insert(RU_type * ru, void * s, uint32_t item, int wt)
+{
+	if (ru->kind==PS_KINDLCL)
+		LCL_Update((LCL_type *) s,item,wt);
+	else
+		QD_Insert((QD_type *) s,item,wt);
+}
+
+/////////////////////////////////////////////////////////////////////
+// tile files
+
+static int RU_Write(RU_type * ru, int tier, int64_t index, void * s)
+{
+	// write the tile to a new file and move it into place, so that a
+	// tile is either all there or not there at all
+	char path[4096], tmp[4200];
+	RU_Header h;
+	FILE * fp;
+	int ok;
+
+	RU_Path(ru,tier,index,path,sizeof(path));
+	snprintf(tmp,sizeof(tmp),"%s.tmp",path);
+	memset(&h,0,sizeof(h));
+	h.shape=ru->shape;
+	h.tier=tier;
+	h.index=index;
+	h.imagesum=PS_Sum(s,h.shape.bytes);
+	fp=fopen(tmp,"wb");
+	ok=fp && fwrite(&h,sizeof(h),1,fp)==1 &&
+		fwrite(s,h.shape.bytes,1,fp)==1 &&
+		fflush(fp)==0 && fdatasync(fileno(fp))==0;
+	if (fp && fclose(fp)!=0) ok=0;
+	if (ok && rename(tmp,path)==0) return 1;
+	fprintf(stderr,"Error: cannot write %s: %s\n",path,strerror(errno));
+	unlink(tmp);
+	return 0;
+}
+
+static void * RU_Load(RU_type * ru, int tier, int64_t index)
+{ // the summary of a tile from its file, or NULL if there is none
+	char path[4096];
+	RU_Header h;
+	FILE * fp;
+	void * s;
+	int ok;
+
+	RU_Path(ru,tier,index,path,sizeof(path));
+	fp=fopen(path,"rb");
+	if (!fp) return NULL;
+	if (fread(&h,sizeof(h),1,fp)!=1 || !PS_SameShape(&h.shape,&ru->shape) ||
+		h.tier!=tier || h.index!=index)
+	{
+		fprintf(stderr,"Error: %s is not a tile of this rollup\n",path);
+		fclose(fp);
+		return NULL;
+	}
+	s=aligned_alloc(64,(h.shape.bytes+63) & ~((uint64_t) 63));
+	if (!s)
+	{
+		fprintf(stderr,"Out of memory error reading %s\n",path);
+		exit(1);
+	}
+	ok=fread(s,h.shape.bytes,1,fp)==1 &&
+		PS_Sum(s,h.shape.bytes)==h.imagesum;
+	fclose(fp);
+	if (!ok)
+	{
+		fprintf(stderr,"Error: %s is damaged\n",path);
+		free(s);
+		return NULL;
+	}
+	if (ru->kind==PS_KINDLCL)
+		LCL_Relocate((LCL_type *) s);
+	else
+		QD_Relocate((QD_type *) s);
+	return s;
+}
+
+static int RU_Exists(RU_type * ru, int tier, int64_t index)
+{
+	char path[4096];
+
+	RU_Path(ru,tier,index,path,sizeof(path));
+	return access(path,F_OK)==0;
+}
+
+static void * RU_LoadOrFresh(RU_type * ru, int64_t index)
+{ // the summary to carry on with for a base interval
+	void * s=RU_Load(ru,0,index);
+	return (s) ? s : RU_Fresh(ru);
+}
+
+static int RU_State(RU_type * ru, int save)
+{
+	// write (save=1) or check and read (save=0) the file describing the
+	// rollup.  Returns 0 if it describes a different rollup
+	char path[4096];
+	FILE * fp;
+	long long open, span;
+	double param, width;
+	int i, kind, logu, tiers, ok;
+
+	snprintf(path,sizeof(path),"%s/rollup",ru->dir);
+	if (save)
+	{
+		fp=fopen(path,"w");
+		if (!fp) return 0;
+		fprintf(fp,"%d %d %.17g %d %.17g %d",RU_VERSION,ru->kind,ru->param,
+			ru->logu,ru->width,ru->tiers);
+		for (i=1;i<ru->tiers;i++)
+			fprintf(fp," %lld",(long long) ru->span[i]);
+		fprintf(fp," %lld\n",(long long) ((ru->started) ? ru->open : -1));
+		return fclose(fp)==0;
+	}
+	fp=fopen(path,"r");
+	if (!fp) return 1; // a new rollup
+	ok=fscanf(fp,"%d %d %lg %d %lg %d",&i,&kind,&param,&logu,&width,
+		&tiers)==6 && i==RU_VERSION && kind==ru->kind && param==ru->param &&
+		logu==ru->logu && width==ru->width && tiers==ru->tiers;
+	for (i=1;ok && i<ru->tiers;i++)
+		ok=fscanf(fp,"%lld",&span)==1 && span==ru->span[i];
+	ok=ok && fscanf(fp,"%lld",&open)==1;
+	fclose(fp);
+	if (ok && open>=0)
+	{
+		ru->started=1;
+		ru->open=open;
+		ru->live=RU_LoadOrFresh(ru,open);
+	}
+	return ok;
+}
+
+/////////////////////////////////////////////////////////////////////
+// the background thread
+
+static void RU_Rollup(RU_type * ru, int tier, int64_t index)
+{ // merge the children of a tile, and write it if it has any
+	int64_t c, f;
+	void * acc, * s;
+
+	f=ru->span[tier]/ru->span[tier-1];
+	acc=NULL;
+	for (c=index*f;c<(index+1)*f;c++)
+	{
+		s=RU_Load(ru,tier-1,c);
+		if (!s) continue;
+		if (!acc)
+			acc=s;
+		else
+			RU_Merge(ru,acc,s);
+	}
+	if (!acc) return;
+	RU_Write(ru,tier,index,acc);
+	RU_Destroy(ru,acc);
+}
+
+static void RU_Roll(RU_type * ru)
+{
+	std::unique_lock<std::mutex> l(ru->lock);
+	RU_Job job;
+	int64_t p;
+	int i;
+
+	while (1)
+	{
+		ru->wake.wait(l,[ru]{ return !ru->jobs.empty() || ru->stop; });
+		if (ru->jobs.empty()) break; // stopped, with nothing left to do
+		job=ru->jobs.front(); // left in the queue, for queries
+		l.unlock();
+
+		if (job.tile) RU_Write(ru,0,job.index,job.tile);
+		// each coarser tile holding this one is complete once the base
+		// interval now open is past its end
+		for (i=1;i<ru->tiers;i++)
+		{
+			p=job.index/ru->span[i];
+			if ((p+1)*ru->span[i]>job.next) break;
+			RU_Rollup(ru,i,p);
+		}
+
+		l.lock();
+		ru->jobs.pop_front();
+		if (job.tile) RU_Destroy(ru,job.tile); // no query is copying it
+		ru->wake.notify_all();
+	}
+}
+
+/////////////////////////////////////////////////////////////////////
+
+static RU_type * RU_Open(const char * dir, int kind, double param,
+	int logu, double width, int tiers, const int * factors)
+{
+	RU_type * ru;
+	void * fresh;
+	int i;
+
+	if (tiers<1 || tiers>RU_MAXTIERS || !(width>0))
+	{
+		fprintf(stderr,"Error: a rollup needs 1 to %d tiers and a positive "
+			"width\n",RU_MAXTIERS);
+		return NULL;
+	}
+	for (i=1;i<tiers;i++)
+		if (factors[i-1]<2)
+		{
+			fprintf(stderr,"Error: each tier must hold at least 2 tiles of "
+				"the one below\n");
+			return NULL;
+		}
+	if (mkdir(dir,0755)!=0 && errno!=EEXIST)
+	{
+		fprintf(stderr,"Error: cannot create %s: %s\n",dir,strerror(errno));
+		return NULL;
+	}
+
+	ru=new RU_type();
+	ru->kind=kind;
+	ru->param=param;
+	ru->logu=logu;
+	fresh=RU_Fresh(ru); // every tile is an image of this size
+	PS_MakeShape(&ru->shape,RU_MAGIC,RU_VERSION,kind,param,logu,
+		RU_Bytes(ru,fresh));
+	RU_Destroy(ru,fresh);
+	ru->dir=strdup(dir);
+	ru->width=width;
+	ru->tiers=tiers;
+	ru->span[0]=1;
+	for (i=1;i<tiers;i++)
+		ru->span[i]=ru->span[i-1]*factors[i-1];
+	if (!RU_State(ru,0) || !RU_State(ru,1))
+	{
+		fprintf(stderr,"Error: %s holds a different rollup, or cannot be "
+			"written\n",dir);
+		if (ru->live) RU_Destroy(ru,ru->live);
+		free(ru->dir);
+		delete ru;
+		return NULL;
+	}
+	ru->roller=std::thread(RU_Roll,ru);
+	return ru;
+}
+
+RU_type * RU_OpenLCL(const char * dir, float fPhi, double width, int tiers,
+	const int * factors)
+{
+	return RU_Open(dir,PS_KINDLCL,fPhi,0,width,tiers,factors);
+}
+
+RU_type * RU_OpenQD(const char * dir, double eps, int logu, double width,
+	int tiers, const int * factors)
+{
+	return RU_Open(dir,PS_KINDQD,eps,logu,width,tiers,factors);
+}
+
+static void RU_Advance(RU_type * ru, double t)
+{ // make the base interval of time t (or a later one) the open one
+	int64_t j;
+
+	j=(int64_t) floor(t/ru->width);
+	if (!ru->started)
+	{
+		ru->started=1;
+		ru->open=j;
+		ru->live=RU_LoadOrFresh(ru,j);
+		return;
+	}
+	if (j<=ru->open) return;
+	{
+		std::lock_guard<std::mutex> l(ru->lock);
+		ru->jobs.push_back({ru->live,ru->open,j});
+		ru->wake.notify_one();
+	}
+	ru->open=j;
+	ru->live=RU_LoadOrFresh(ru,j);
+}
+
+void RU_Update(RU_type * ru, uint32_t item, double t, int wt)
+{
+	RU_Advance(ru,t);
+	RU_Insert(ru,ru->live,item,wt);
+}
+
+static void * RU_Base(RU_type * ru, int64_t index)
+{ // a copy of the summary of a base interval, or NULL if there is none
+	std::deque<RU_Job>::iterator j;
+
+	if (ru->started && index==ru->open)
+		return RU_Clone(ru,ru->live);
+	{
+		std::lock_guard<std::mutex> l(ru->lock);
+		for (j=ru->jobs.begin();j!=ru->jobs.end();++j)
+			if (j->tile && j->index==index)
+				return RU_Clone(ru,j->tile);
+	}
+	return RU_Load(ru,0,index);
+}
+
+static void RU_Plan(RU_type * ru, double t1, double t2,
+	std::vector<std::pair<int, int64_t> > * tiles)
+{
+	// the tiles that cover [t1,t2): at each step the coarsest one that
+	// starts there, fits, and has been written
+	int64_t idx, end;
+	int i;
+
+	idx=(int64_t) floor(t1/ru->width);
+	end=(int64_t) ceil(t2/ru->width);
+	while (idx<end)
+	{
+		for (i=ru->tiers-1;i>0;i--)
+			if (idx%ru->span[i]==0 && idx+ru->span[i]<=end &&
+				RU_Exists(ru,i,idx/ru->span[i]))
+				break;
+		tiles->push_back(std::make_pair(i,idx/ru->span[i]));
+		idx+=ru->span[i];
+	}
+}
+
+static void * RU_Query(RU_type * ru, double t1, double t2)
+{
+	std::vector<std::pair<int, int64_t> > tiles;
+	void * acc, * s;
+	size_t i;
+
+	RU_Plan(ru,t1,t2,&tiles);
+	acc=NULL;
+	for (i=0;i<tiles.size();i++)
+	{
+		s=(tiles[i].first==0) ? RU_Base(ru,tiles[i].second) :
+			RU_Load(ru,tiles[i].first,tiles[i].second);
+		if (!s) continue;
+		if (!acc)
+			acc=s;
+		else
+			RU_Merge(ru,acc,s);
+	}
+	return (acc) ? acc : RU_Fresh(ru);
+}
+
+LCL_type * RU_QueryLCL(RU_type * ru, double t1, double t2)
+{
+	return (ru->kind==PS_KINDLCL) ? (LCL_type *) RU_Query(ru,t1,t2) : NULL;
+}
+
+QD_type * RU_QueryQD(RU_type * ru, double t1, double t2)
+{
+	return (ru->kind==PS_KINDQD) ? (QD_type *) RU_Query(ru,t1,t2) : NULL;
+}
+
+int RU_Tiles(RU_type * ru, double t1, double t2)
+{
+	std::vector<std::pair<int, int64_t> > tiles;
+
+	RU_Plan(ru,t1,t2,&tiles);
+	return (int) tiles.size();
+}
+
+void RU_Sync(RU_type * ru)
+{
+	std::unique_lock<std::mutex> l(ru->lock);
+
+	ru->wake.wait(l,[ru]{ return ru->jobs.empty(); });
+}
+
+void RU_Close(RU_type * ru)
+{
+	if (!ru) return;
+	if (ru->started)
+	{ // the open tile is written, but not rolled up: it may go on
+		std::lock_guard<std::mutex> l(ru->lock);
+		ru->jobs.push_back({ru->live,ru->open,ru->open});
+		ru->wake.notify_one();
+	}
+	RU_Sync(ru);
+	RU_State(ru,1);
+	{
+		std::lock_guard<std::mutex> l(ru->lock);
+		ru->stop=1;
+		ru->wake.notify_all();
+	}
+	ru->roller.join();
+	free(ru->dir);
+	delete ru;
+}
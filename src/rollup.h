@@ -0,0 +1,83 @@
+// rollup.h -- header file for time tiered rollups of summaries
+// one LCL summary or q-digest per base interval of time (say a minute),
+// stored as a file, and merged in the background into tiles of coarser
+// tiers (say hours and days), so that any range of time is answered by
+// merging a few tiles
+
+#ifndef ROLLUP_h
+#define ROLLUP_h
+
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include "lossycount.h"
+#include "qdigest.h"
+#include "persist.h"
+
+#define RU_MAGIC 0x4C55524C // "LRUL"
+#define RU_VERSION 1
+#define RU_MAXTIERS 8
+
+typedef struct ru_header_t
+{ // the start of a tile file, followed by the image of the summary
+  PS_Shape shape;      // with RU_MAGIC, and a kind of PS_KINDLCL or PS_KINDQD
+  int64_t tier;
+  int64_t index;       // the tile covers base intervals
+                       // [index*span, (index+1)*span) of its tier
+  uint64_t imagesum;   // checksum of the image
+} RU_Header;
+
+typedef struct ru_job_t
+{ // a base tile that has closed, for the background thread
+  void *tile;     // its summary, or NULL if already written
+  int64_t index;  // its number
+  int64_t next;   // the base interval now open: coarser tiles that end
+                  // by then are complete, and are rolled up
+} RU_Job;
+
+typedef struct RU_type
+{
+  int kind;         // PS_KINDLCL or PS_KINDQD
+  double param;     // phi, or epsilon
+  int logu;
+  PS_Shape shape;   // that every tile must have
+  char *dir;        // where the tiles are kept
+  double width;     // length of a base interval
+  int tiers;        // tier 0 is the base
+  int64_t span[RU_MAXTIERS]; // base intervals per tile of each tier
+  int started;      // a base interval is open
+  int64_t open;     // number of the open base interval, and
+  void *live;       // its summary, an LCL_type or QD_type
+  std::deque<RU_Job> jobs; // closed tiles still to be written: the
+                    // first is the one being worked on
+  int stop;         // the background thread should finish
+  std::mutex lock;  // guards jobs and stop
+  std::condition_variable wake;
+  std::thread roller; // writes base tiles and rolls them up
+} RU_type;
+
+extern RU_type * RU_OpenLCL(const char * dir, float fPhi, double width,
+  int tiers, const int * factors);
+extern RU_type * RU_OpenQD(const char * dir, double eps, int logu,
+  double width, int tiers, const int * factors);
+// tiles are kept in dir.  Base intervals are width long, and a tile of
+// tier i>0 is made of factors[i-1] tiles of tier i-1: {60, 24} with a
+// width of 60 seconds gives minute, hour and day tiles.  A directory
+// used before picks up where it was left.  Returns NULL if dir cannot
+// be used, or holds tiles of another kind or shape
+extern void RU_Update(RU_type *, uint32_t, double, int);
+// an item (or a value, for a q-digest) at a time, with a weight.  Times
+// are not negative, and should not go back by more than an interval: an
+// update older than the open interval is counted in it
+extern LCL_type * RU_QueryLCL(RU_type *, double, double);
+extern QD_type * RU_QueryQD(RU_type *, double, double);
+// a summary of the updates with times in [t1,t2), widened to whole base
+// intervals, merged from as few tiles as there are.  The caller
+// destroys it.  Updates and queries are made from one thread
+extern int RU_Tiles(RU_type *, double, double);
+// how many tiles a query of [t1,t2) would look at, at the moment
+extern void RU_Sync(RU_type *); // wait until closed tiles are written
+extern void RU_Close(RU_type *); // write the open tile too, and close
+
+#endif
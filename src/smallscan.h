@@ -0,0 +1,103 @@
+// smallscan.h -- AVX2 scans of small summaries kept as flat arrays
+// Frequent (frequent.h), LCLP_type (lclpool.h) and LCLK_type<K>
+// (lclsmall.h) keep k items and their counts in two arrays, with k a
+// multiple of SCAN_LANES, and look up an item or the smallest count by
+// comparing eight counters at a time.  The arrays are scanned in chunks
+// of SCAN_CHUNK counters: within a chunk the masks of the compares are
+// gathered into one word, with no data-dependent branches, and the scan
+// may stop only between chunks.  For k up to SCAN_CHUNK that is one
+// fixed-length pass.
+
+#ifndef SMALLSCAN_h
+#define SMALLSCAN_h
+
+#include <stdint.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SCAN_AVX2
+#endif
+
+#define SCAN_LANES 8  // counters compared per step
+#define SCAN_CHUNK 64 // counters between chances to stop: one 64 bit mask
+
+static inline int SCAN_UseAVX2()
+{ // decided once, on the first call
+#ifdef SCAN_AVX2
+  static int avx2=__builtin_cpu_supports("avx2") ? 1 : 0;
+  return avx2;
+#else
+  return 0;
+#endif
+}
+
+#ifdef SCAN_AVX2
+__attribute__((target("avx2")))
+static inline int SCAN_FindAVX2(const int * counts, const uint32_t * items,
+                                int k, uint32_t item, int live,
+                                int * freeslot)
+{
+  // the first counter holding item with a count above live, or -1.  If
+  // freeslot is not NULL and item is not there, it gets the first
+  // counter whose count is live or less (or -1)
+  __m256i vitem, vlive, ct, ok;
+  uint64_t m, f;
+  int i, j, end;
+
+  vitem=_mm256_set1_epi32((int) item);
+  vlive=_mm256_set1_epi32(live);
+  if (freeslot) *freeslot=-1;
+  for (j=0;j<k;j+=SCAN_CHUNK)
+  {
+    end=(k-j<SCAN_CHUNK) ? k : j+SCAN_CHUNK;
+    m=f=0;
+    for (i=j;i<end;i+=SCAN_LANES)
+    {
+      ct=_mm256_loadu_si256((const __m256i *) (counts+i));
+      ok=_mm256_cmpgt_epi32(ct,vlive);
+      f|=(uint64_t) (~(unsigned) _mm256_movemask_ps(_mm256_castsi256_ps(ok))
+        & 0xFF)<<(i-j);
+      ok=_mm256_and_si256(ok,_mm256_cmpeq_epi32(
+        _mm256_loadu_si256((const __m256i *) (items+i)),vitem));
+      m|=(uint64_t) (unsigned) _mm256_movemask_ps(_mm256_castsi256_ps(ok))
+        <<(i-j);
+    }
+    if (m) return j+__builtin_ctzll(m);
+    if (freeslot && *freeslot<0 && f) *freeslot=j+__builtin_ctzll(f);
+  }
+  return -1;
+}
+
+__attribute__((target("avx2")))
+static inline int SCAN_MinAVX2(const int * counts, int k)
+{
+  // the first counter with the smallest count: take the lane-wise
+  // minimum, spread the smallest lane to all eight, then compare to
+  // find where it sits
+  __m256i vmin, eq;
+  uint64_t m;
+  int i, j, end;
+
+  vmin=_mm256_loadu_si256((const __m256i *) counts);
+  for (i=SCAN_LANES;i<k;i+=SCAN_LANES)
+    vmin=_mm256_min_epi32(vmin,
+      _mm256_loadu_si256((const __m256i *) (counts+i)));
+  vmin=_mm256_min_epi32(vmin,_mm256_permute2x128_si256(vmin,vmin,1));
+  vmin=_mm256_min_epi32(vmin,_mm256_shuffle_epi32(vmin,0x4E));
+  vmin=_mm256_min_epi32(vmin,_mm256_shuffle_epi32(vmin,0xB1));
+  for (j=0;;j+=SCAN_CHUNK)
+  {
+    end=(k-j<SCAN_CHUNK) ? k : j+SCAN_CHUNK;
+    m=0;
+    for (i=j;i<end;i+=SCAN_LANES)
+    {
+      eq=_mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *) (counts+i)),
+        vmin);
+      m|=(uint64_t) (unsigned) _mm256_movemask_ps(_mm256_castsi256_ps(eq))
+        <<(i-j);
+    }
+    if (m) return j+__builtin_ctzll(m);
+  }
+}
+#endif
+
+#endif
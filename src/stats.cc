@@ -0,0 +1,125 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include "stats.h"
+/********************************************************************
+Latency histograms and event counts for the update routines
+
+Each timed update adds its length in ticks to a log-linear histogram:
+values below 2^ST_SUBBITS get a bucket each, and every larger power of
+two is split into 2^ST_SUBBITS equal buckets, so any bucket is within
+1/2^ST_SUBBITS of the values it holds (6% for the default of 4),
+whatever the scale.  This is the layout of HdrHistogram, and keeps the
+tail percentiles accurate at a fixed cost of a few kilobytes.
+
+This work is licensed under the Creative Commons
+Attribution-NonCommercial License. To view a copy of this license,
+visit http://creativecommons.org/licenses/by-nc/1.0/ or send a letter
+to Creative Commons, 559 Nathan Abbott Way, Stanford, California
+94305, USA.
+*********************************************************************/
+
+static const char * ST_names[ST_EVENTS] = {
+	"updates", "flushes", "compressions", "unbuffers", "sorts", "evictions",
+	"probes", "heapifies", "sift_levels", "rehashes"
+};
+
+static inline int ST_Bucket(unsigned long long v)
+{ // the histogram bucket holding value v
+	int msb;
+
+	if (v<(1ULL<<ST_SUBBITS)) return (int) v;
+	msb=63-__builtin_clzll(v);
+	if (msb>=ST_OCTAVES+ST_SUBBITS) return ST_BUCKETS-1;
+	return ((msb-ST_SUBBITS+1)<<ST_SUBBITS) +
+		(int) ((v>>(msb-ST_SUBBITS)) & ((1<<ST_SUBBITS)-1));
+}
+
+static double ST_BucketTop(int b)
+{ // the largest value that falls in bucket b
+	int e;
+
+	if (b<(1<<ST_SUBBITS)) return b;
+	e=(b>>ST_SUBBITS)-1;
+	return (double) ((((unsigned long long) (b&((1<<ST_SUBBITS)-1))+
+		(1<<ST_SUBBITS)+1)<<e)-1);
+}
+
+void ST_Record(ST_type ** st, unsigned long long ticks)
+{
+	ST_type * s=*st;
+
+	if (!s)
+	{
+		s=(ST_type *) calloc(1,sizeof(ST_type));
+		if (!s)
+		{
+			fprintf(stderr,"Out of memory error allocating statistics\n");
+			exit(1);
+		}
+		*st=s;
+	}
+	s->updates++;
+	s->ticks+=ticks;
+	if (ticks>s->maxticks) s->maxticks=ticks;
+	s->hist[ST_Bucket(ticks)]++;
+}
+
+void ST_Destroy(ST_type * st)
+{
+	free(st);
+}
+
+void ST_Reset(ST_type * st)
+{
+	if (st) memset(st,0,sizeof(ST_type));
+}
+
+double ST_NsPerTick()
+{
+	// compare the tick counter with the system clock over 20ms
+	static double nspertick=0.0;
+#ifdef SKETCH_STATS
+	std::chrono::steady_clock::time_point t0, t1;
+	unsigned long long c0, c1;
+
+	if (nspertick>0.0) return nspertick;
+	t0=std::chrono::steady_clock::now();
+	c0=ST_Ticks();
+	do {
+		t1=std::chrono::steady_clock::now();
+	} while (std::chrono::duration<double,std::nano>(t1-t0).count()<20e6);
+	c1=ST_Ticks();
+	nspertick=std::chrono::duration<double,std::nano>(t1-t0).count()/
+		(double) (c1-c0);
+#endif
+	return nspertick;
+}
+
+double ST_Percentile(ST_type * st, double p)
+{
+	// the number of ticks that a fraction p of updates did not exceed,
+	// rounded up to the top of its bucket (but no more than the maximum)
+	long long rank, seen;
+	double top;
+	int b;
+
+	if (!st || st->updates==0) return 0.0;
+	rank=(long long) (p*st->updates+0.5);
+	if (rank<1) rank=1;
+	if (rank>st->updates) rank=st->updates;
+	seen=0;
+	for (b=0;b<ST_BUCKETS;b++)
+	{
+		seen+=st->hist[b];
+		if (seen>=rank) break;
+	}
+	top=ST_BucketTop(b);
+	return (top<(double) st->maxticks) ? top : (double) st->maxticks;
+}
+
+const char * ST_EventName(int e)
+{
+	return (e>=0 && e<ST_EVENTS) ? ST_names[e] : "";
+}
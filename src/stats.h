@@ -0,0 +1,103 @@
+// stats.h -- optional instrumentation of the update routines
+// Compile with -DSKETCH_COUNTERS to count updates and the slow-path
+// events that cause latency spikes (a few increments per update, kept
+// inside each structure), or with -DSKETCH_STATS to also time every
+// update with the cycle counter into a log-linear (HDR style)
+// histogram.  Without either the macros below compile to nothing and
+// the structures carry no extra fields.
+
+#ifndef STATS_h
+#define STATS_h
+
+#ifdef SKETCH_STATS
+#define SKETCH_COUNTERS
+#endif
+
+#include <stdint.h>
+
+#define ST_SUBBITS 4 // each power of two is split into 2^ST_SUBBITS buckets
+#define ST_OCTAVES 40 // times of 2^40 ticks or more share the last bucket
+#define ST_BUCKETS ((ST_OCTAVES+1)<<ST_SUBBITS)
+
+enum {
+  ST_UPDATES,  // calls to the update routine
+  ST_FLUSH,    // LC, LCD: sort and merge of a full epoch buffer
+  ST_COMPRESS, // QD: compression triggered from an insert
+  ST_UNBUFFER, // QD: buffered items converted into the tree
+  ST_SORT,     // QDSW: sort of the full time buffer
+  ST_EVICT,    // LCL, LCU: smallest counter handed to a new item
+  ST_PROBE,    // LCL: hash chain entries compared against the item
+  ST_HEAPIFY,  // LCL: calls to the heap sift-down
+  ST_SIFT,     // LCL: total levels moved by sift-downs
+  ST_REHASH,   // LCL, LCU: new hash function after an overlong chain
+  ST_EVENTS
+};
+
+typedef struct SC_type
+{ // event counters, kept inline so that counting needs no test
+  long long events[ST_EVENTS];
+  int maxchain; // LCL: longest hash chain walked by an update
+  int maxsift;  // LCL: most levels moved by a single sift-down
+} SC_type;
+
+typedef struct ST_type
+{
+  long long updates;          // number of timed updates
+  unsigned long long ticks;   // total ticks over all timed updates
+  unsigned long long maxticks; // slowest single update
+  long long hist[ST_BUCKETS];  // log-linear histogram of ticks per update
+} ST_type;
+
+extern void ST_Record(ST_type **, unsigned long long);
+// add one timed update; allocates the statistics on first use
+extern void ST_Destroy(ST_type *);
+extern void ST_Reset(ST_type *);
+extern double ST_NsPerTick(); // measured once, on the first call
+extern double ST_Percentile(ST_type *, double); // in ticks, eg 0.999
+extern const char * ST_EventName(int);
+
+#ifdef SKETCH_STATS
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+static inline unsigned long long ST_Ticks() { return __rdtsc(); }
+#else
+#include <time.h>
+static inline unsigned long long ST_Ticks()
+{ // no cycle counter: fall back to nanoseconds
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return (unsigned long long) ts.tv_sec*1000000000ULL+ts.tv_nsec;
+}
+#endif
+#define ST_TIMER ST_type * stats;
+#define ST_TIME() unsigned long long st_t0=ST_Ticks()
+#define ST_STOP(st) ST_Record(&(st),ST_Ticks()-st_t0)
+#define ST_FREE(st) ST_Destroy(st)
+#define ST_DETACH(st) ((st)=NULL) // a copy starts its own statistics
+#else
+#define ST_TIMER
+#define ST_TIME() do {} while (0)
+#define ST_STOP(st) do {} while (0)
+#define ST_FREE(st) do {} while (0)
+#define ST_DETACH(st) do {} while (0)
+#endif
+
+#ifdef SKETCH_COUNTERS
+#define ST_FIELD ST_TIMER SC_type sc;
+#define ST_START(sc) ST_TIME(); (sc).events[ST_UPDATES]++
+#define ST_EVENT(sc,e) ((sc).events[e]++)
+#define ST_ADD(sc,e,v) ((sc).events[e]+=(v))
+#define ST_MAX(sc,f,v) do { if ((v)>(sc).f) (sc).f=(v); } while (0)
+#define ST_MARK(sc,e) long long st_mark=(sc).events[e]
+#define ST_MAXSINCE(sc,f,e) ST_MAX(sc,f,(int) ((sc).events[e]-st_mark))
+#else
+#define ST_FIELD
+#define ST_START(sc) do {} while (0)
+#define ST_EVENT(sc,e) do {} while (0)
+#define ST_ADD(sc,e,v) do {} while (0)
+#define ST_MAX(sc,f,v) do {} while (0)
+#define ST_MARK(sc,e) do {} while (0)
+#define ST_MAXSINCE(sc,f,e) do {} while (0)
+#endif
+
+#endif
@@ -1,4 +1,20 @@
 #include "lossycount.h"
+#include "countmin.h"
+#include "gk4.h"
+#include "cgt.h"
+#include "ccfc.h"
+#include "frequent.h"
+#include "lclpool.h"
+#include "persist.h"
+#include "lclshare.h"
+#include "lcldecay.h"
+#include "lclwindow.h"
+#include "lclchange.h"
+#include "lclhhh.h"
+#include "lclquant.h"
+#include "rollup.h"
+#include "qdigest.h"
+#include "stats.h"
 #include <boost/python.hpp>
 #include <boost/python/list.hpp>
 #include <boost/python/tuple.hpp>
@@ -28,6 +44,47 @@ vector<string> word_vec(char* c,unsigned win_width){
     return str;
 } 
 */
+template <typename T>
+std::vector<T> to_vector(object seq){
+    // copy a python sequence into a contiguous array for the batch routines
+    std::vector<T> res(len(seq));
+    for (size_t i=0;i<res.size();++i)
+        res[i]=extract<T>(seq[i]);
+    return res;
+}
+
+template <typename T>
+dict stats_dict(T* x){
+    // event counts (with SKETCH_COUNTERS), and update latency percentiles
+    // in ns (with SKETCH_STATS); empty in a normal build
+    dict res;
+#if !defined(SKETCH_COUNTERS) && !defined(SKETCH_STATS)
+    (void) x;
+#endif
+#ifdef SKETCH_COUNTERS
+    for (int e=0;e<ST_EVENTS;++e)
+        res[ST_EventName(e)]=x->sc.events[e];
+    if (x->sc.events[ST_PROBE])
+        res["max_chain"]=x->sc.maxchain;
+    if (x->sc.events[ST_HEAPIFY])
+        res["max_sift"]=x->sc.maxsift;
+#endif
+#ifdef SKETCH_STATS
+    static const double pct[]={0.5,0.9,0.99,0.999};
+    static const char* names[]={"p50_ns","p90_ns","p99_ns","p999_ns"};
+    ST_type* st=x->stats;
+    double ns=ST_NsPerTick();
+
+    if (st && st->updates) {
+        res["mean_ns"]=ns*st->ticks/st->updates;
+        for (int i=0;i<4;++i)
+            res[names[i]]=ns*ST_Percentile(st,pct[i]);
+        res["max_ns"]=ns*st->maxticks;
+    }
+#endif
+    return res;
+}
+
 class LossyCount{
     LCL_type* _lcl;
     public:
@@ -35,18 +92,42 @@ class LossyCount{
             _lcl(LCL_Init(phi))
         {
         }
+        LossyCount(float phi,int seed):
+            _lcl(LCL_InitSeed(phi,seed))
+        {
+        }
        
         ~LossyCount(){
           destroy();
         }
         void destroy(){
             LCL_Destroy(_lcl);
+            _lcl=NULL;
         }
         
         void incr(LCLitem_t item,int value=1){
             LCL_Update(_lcl,item,value);
         }
 
+        void incr_batch(object items,object values,bool aggregate){
+            std::vector<LCLitem_t> it=to_vector<LCLitem_t>(items);
+            std::vector<LCLweight_t> wt;
+            if (!values.is_none()) {
+                wt=to_vector<LCLweight_t>(values);
+                if (wt.size()!=it.size()) {
+                    PyErr_SetString(PyExc_ValueError,
+                        "items and values must have the same length");
+                    throw_error_already_set();
+                }
+            }
+            if (aggregate)
+                LCL_UpdateBatchAggregate(_lcl,it.data(),
+                    wt.empty()?NULL:wt.data(),it.size());
+            else
+                LCL_UpdateBatch(_lcl,it.data(),wt.empty()?NULL:wt.data(),
+                    it.size());
+        }
+
         unsigned capacity(){
             return LCL_Size(_lcl); 
         }
@@ -58,6 +139,10 @@ class LossyCount{
             return LCL_PointErr(_lcl,k);
         } 
 
+        dict stats(){
+            return stats_dict(_lcl);
+        }
+
         list output(LCLweight_t thresh){
             list res;
 
@@ -73,21 +158,1327 @@ class LossyCount{
             return res;
         }
 
+#ifdef LCL_PAYLOAD
+        void incr_payload(LCLitem_t item,LCLvalue_t x,int value=1){
+            LCL_UpdateValue(_lcl,item,value,x);
+        }
+
+        void incr_batch_payload(object items,object xs,object values){
+            std::vector<LCLitem_t> it=to_vector<LCLitem_t>(items);
+            std::vector<LCLvalue_t> xv=to_vector<LCLvalue_t>(xs);
+            std::vector<LCLweight_t> wt;
+            if (!values.is_none())
+                wt=to_vector<LCLweight_t>(values);
+            if (xv.size()!=it.size() || (!wt.empty() && wt.size()!=it.size())) {
+                PyErr_SetString(PyExc_ValueError,
+                    "items, xs and values must have the same length");
+                throw_error_already_set();
+            }
+            LCL_UpdateBatchValues(_lcl,it.data(),wt.empty()?NULL:wt.data(),
+                xv.data(),it.size());
+        }
+
+        object payload(LCLitem_t k){
+            // (sum, min, max) of the values of an item, or None
+            LCLPayload agg;
+            if (!LCL_PointPayload(_lcl,k,&agg) || agg.min>agg.max)
+                return object();
+            return make_tuple(agg.sum,agg.min,agg.max);
+        }
+
+        list output_payload(LCLweight_t thresh){
+            // (item, count, sum, min, max) for each count of thresh or more
+            list res;
+
+            for (int i=1;i<=_lcl->size;++i)
+            {
+                LCLCounter& c = _lcl->counters[i];
+                if (c.count>=thresh && c.count>0 && c.agg.min<=c.agg.max)
+                    res.append(make_tuple(c.item,c.count,c.agg.sum,
+                                          c.agg.min,c.agg.max));
+            }
+            return res;
+        }
+#endif
+};
+
+class CountMin{
+    CM_type* _cm;
+    bool _conservative;
+    public:
+        CountMin(int width,int depth,int seed=1,bool conservative=false):
+            _cm(CM_Init(width,depth,seed)),
+            _conservative(conservative)
+        {
+        }
+
+        ~CountMin(){
+          destroy();
+        }
+        void destroy(){
+            CM_Destroy(_cm);
+            _cm=NULL;
+        }
+
+        void incr(unsigned int item,int value=1){
+            if (_conservative)
+                CM_UpdateConservative(_cm,item,value);
+            else
+                CM_Update(_cm,item,value);
+        }
+
+        void incr_batch(object items,object values){
+            std::vector<unsigned int> it=to_vector<unsigned int>(items);
+            std::vector<int> wt;
+            if (!values.is_none()) {
+                wt=to_vector<int>(values);
+                if (wt.size()!=it.size()) {
+                    PyErr_SetString(PyExc_ValueError,
+                        "items and values must have the same length");
+                    throw_error_already_set();
+                }
+            }
+            if (_conservative)
+                CM_UpdateConservativeBatch(_cm,it.data(),
+                    wt.empty()?NULL:wt.data(),it.size());
+            else
+                CM_UpdateBatch(_cm,it.data(),wt.empty()?NULL:wt.data(),it.size());
+        }
+
+        int est(unsigned int item){
+            return CM_PointEst(_cm,item);
+        }
+
+        list est_batch(object items){
+            std::vector<unsigned int> it=to_vector<unsigned int>(items);
+            std::vector<int> out(it.size());
+            list res;
+
+            CM_PointEstBatch(_cm,it.data(),out.data(),it.size());
+            for (size_t i=0;i<out.size();++i)
+                res.append(out[i]);
+            return res;
+        }
+
+        void merge(CountMin& other){
+            if (!CM_Merge(_cm,other._cm)) {
+                PyErr_SetString(PyExc_ValueError,
+                    "sketches must have the same width, depth and seed");
+                throw_error_already_set();
+            }
+        }
+
+        long long total(){
+            return _cm->count;
+        }
+
+        unsigned capacity(){
+            return CM_Size(_cm);
+        }
+};
+
+class QDigest{
+    QD_type* _qd;
+    public:
+        QDigest(double eps,int logu):
+            _qd(QD_Init(eps,logu,-1))
+        {
+        }
+
+        ~QDigest(){
+          destroy();
+        }
+        void destroy(){
+            QD_Destroy(_qd);
+            _qd=NULL;
+        }
+
+        void insert(size_t item,int value=1){
+            QD_Insert(_qd,item,value);
+        }
+
+        void insert_batch(object items){
+            std::vector<unsigned int> it=to_vector<unsigned int>(items);
+            for (size_t i=0;i<it.size();++i)
+                QD_Insert(_qd,it[i],1);
+        }
+
+        unsigned int quantile(double phi){
+            return QD_OutputQuantile(_qd,phi);
+        }
+
+        list quantiles(object phis){
+            std::vector<double> ph=to_vector<double>(phis);
+            std::vector<unsigned int> out(ph.size());
+            list res;
+
+            QD_OutputQuantiles(_qd,ph.data(),ph.size(),out.data());
+            for (size_t i=0;i<out.size();++i)
+                res.append(out[i]);
+            return res;
+        }
+
+        dict stats(){
+            return stats_dict(_qd);
+        }
+
+        unsigned capacity(){
+            return QD_Size(_qd);
+        }
+};
+
+class GK{
+    GK_type* _gk;
+    public:
+        GK(double eps):
+            _gk(GK_Init(eps))
+        {
+        }
+
+        ~GK(){
+          destroy();
+        }
+        void destroy(){
+            GK_Destroy(_gk);
+            _gk=NULL;
+        }
+
+        void insert(double value){
+            GK_Insert(_gk,value);
+        }
+
+        void insert_batch(object values){
+            std::vector<double> v=to_vector<double>(values);
+            GK_InsertBatch(_gk,v.data(),v.size());
+        }
+
+        double quantile(double phi){
+            return GK_OutputQuantile(_gk,phi);
+        }
+
+        list quantiles(object phis){
+            std::vector<double> ph=to_vector<double>(phis);
+            std::vector<double> out(ph.size());
+            list res;
+
+            GK_OutputQuantiles(_gk,ph.data(),ph.size(),out.data());
+            for (size_t i=0;i<out.size();++i)
+                res.append(out[i]);
+            return res;
+        }
+
+        unsigned capacity(){
+            return GK_Size(_gk);
+        }
+};
+
+class GroupTest{
+    CGT_type* _cgt;
+    public:
+        GroupTest(int buckets,int tests,int seed=1,int logn=32):
+            _cgt(CGT_Init(buckets,tests,logn,seed))
+        {
+        }
+
+        ~GroupTest(){
+          destroy();
+        }
+        void destroy(){
+            CGT_Destroy(_cgt);
+            _cgt=NULL;
+        }
+
+        void incr(unsigned int item,int value=1){
+            CGT_Update(_cgt,item,value);
+        }
+
+        void incr_batch(object items,object values){
+            std::vector<unsigned int> it=to_vector<unsigned int>(items);
+            std::vector<int> wt;
+            if (!values.is_none()) {
+                wt=to_vector<int>(values);
+                if (wt.size()!=it.size()) {
+                    PyErr_SetString(PyExc_ValueError,
+                        "items and values must have the same length");
+                    throw_error_already_set();
+                }
+            }
+            CGT_UpdateBatch(_cgt,it.data(),wt.empty()?NULL:wt.data(),it.size());
+        }
+
+        int est(unsigned int item){
+            return CGT_PointEst(_cgt,item);
+        }
+
+        list output(int thresh){
+            list res;
+            std::map<uint32_t, uint32_t> hh=CGT_Output(_cgt,thresh);
+
+            for (std::map<uint32_t, uint32_t>::iterator i=hh.begin();
+                 i!=hh.end();++i)
+                res.append(make_tuple(i->first,i->second));
+            return res;
+        }
+
+        void merge(GroupTest& other){
+            if (!CGT_Merge(_cgt,other._cgt)) {
+                PyErr_SetString(PyExc_ValueError,
+                    "sketches must have the same shape and seed");
+                throw_error_already_set();
+            }
+        }
+
+        long long total(){
+            return _cgt->count;
+        }
+
+        unsigned capacity(){
+            return CGT_Size(_cgt);
+        }
+};
+
+class CountSketch{
+    CCFC_type* _ccfc;
+    public:
+        CountSketch(int width,int depth,int seed=1):
+            _ccfc(CCFC_Init(width,depth,seed))
+        {
+        }
+
+        ~CountSketch(){
+          destroy();
+        }
+        void destroy(){
+            CCFC_Destroy(_ccfc);
+            _ccfc=NULL;
+        }
+
+        void incr(unsigned int item,int value=1){
+            CCFC_Update(_ccfc,item,value);
+        }
+
+        void incr_batch(object items,object values){
+            std::vector<unsigned int> it=to_vector<unsigned int>(items);
+            std::vector<int> wt;
+            if (!values.is_none()) {
+                wt=to_vector<int>(values);
+                if (wt.size()!=it.size()) {
+                    PyErr_SetString(PyExc_ValueError,
+                        "items and values must have the same length");
+                    throw_error_already_set();
+                }
+            }
+            CCFC_UpdateBatch(_ccfc,it.data(),wt.empty()?NULL:wt.data(),it.size());
+        }
+
+        int est(unsigned int item){
+            return CCFC_PointEst(_ccfc,item);
+        }
+
+        long long inner(CountSketch& other){
+            if (!CCFC_Compatible(_ccfc,other._ccfc)) {
+                PyErr_SetString(PyExc_ValueError,
+                    "sketches must have the same width, depth and seed");
+                throw_error_already_set();
+            }
+            return CCFC_InnerProd(_ccfc,other._ccfc);
+        }
+
+        void merge(CountSketch& other){
+            if (!CCFC_Merge(_ccfc,other._ccfc)) {
+                PyErr_SetString(PyExc_ValueError,
+                    "sketches must have the same width, depth and seed");
+                throw_error_already_set();
+            }
+        }
+
+        long long total(){
+            return _ccfc->count;
+        }
+
+        unsigned capacity(){
+            return CCFC_Size(_ccfc);
+        }
+};
+
+class Frequent{
+    F_type* _f;
+    public:
+        Frequent(float phi):
+            _f(F_Init(phi))
+        {
+        }
+
+        ~Frequent(){
+          destroy();
+        }
+        void destroy(){
+            F_Destroy(_f);
+            _f=NULL;
+        }
+
+        void incr(uint32_t item,int value=1){
+            F_Update(_f,item,value);
+        }
+
+        unsigned capacity(){
+            return F_Size(_f);
+        }
+
+        int est(uint32_t k){
+            return F_PointEst(_f,k);
+        }
+        int err(uint32_t k){
+            return F_PointErr(_f,k);
+        }
+
+        list output(int thresh){
+            list res;
+            std::map<uint32_t, uint32_t> hh=F_Output(_f,thresh);
+
+            for (std::map<uint32_t, uint32_t>::iterator i=hh.begin();
+                 i!=hh.end();++i)
+                res.append(make_tuple(i->first,i->second));
+            return res;
+        }
+};
+
+class DecayedLossyCount{
+    DLCL_type* _dlcl;
+    public:
+        DecayedLossyCount(float phi,double lambda):
+            _dlcl(DLCL_Init(phi,lambda))
+        {}
+        DecayedLossyCount(float phi,double lambda,int seed):
+            _dlcl(DLCL_InitSeed(phi,lambda,seed))
+        {}
+
+        ~DecayedLossyCount(){
+          DLCL_Destroy(_dlcl);
+        }
+
+        void incr(LCLitem_t item,double t,double value=1.0){
+            DLCL_Update(_dlcl,item,t,value);
+        }
+
+        void incr_batch(object items,object times,object values){
+            std::vector<LCLitem_t> it=to_vector<LCLitem_t>(items);
+            std::vector<double> ts=to_vector<double>(times);
+            std::vector<double> wt;
+            if (!values.is_none())
+                wt=to_vector<double>(values);
+            if (ts.size()!=it.size() || (!wt.empty() && wt.size()!=it.size())) {
+                PyErr_SetString(PyExc_ValueError,
+                    "items, times and values must have the same length");
+                throw_error_already_set();
+            }
+            for (size_t i=0;i<it.size();++i)
+                DLCL_Update(_dlcl,it[i],ts[i],wt.empty()?1.0:wt[i]);
+        }
+
+        unsigned capacity(){
+            return DLCL_Size(_dlcl);
+        }
+
+        double est(LCLitem_t k,double t){
+            return DLCL_PointEst(_dlcl,k,t);
+        }
+        double err(LCLitem_t k,double t){
+            return DLCL_PointErr(_dlcl,k,t);
+        }
+        double total(double t){
+            return DLCL_Total(_dlcl,t);
+        }
+
+        list output(double thresh,double t){
+            // (item, decayed weight) for each weight of thresh or more at t
+            list res;
+            std::map<uint32_t, double> hh=DLCL_Output(_dlcl,thresh,t);
+
+            for (std::map<uint32_t, double>::iterator i=hh.begin();
+                 i!=hh.end();++i)
+                res.append(make_tuple(i->first,i->second));
+            return res;
+        }
+};
+
+class WindowLossyCount{
+    WLCL_type* _wlcl;
+    public:
+        WindowLossyCount(float phi,int panes,double width):
+            _wlcl(WLCL_Init(phi,panes,width))
+        {}
+
+        ~WindowLossyCount(){
+          WLCL_Destroy(_wlcl);
+        }
+
+        void incr(LCLitem_t item,double t,int value=1){
+            WLCL_Update(_wlcl,item,t,value);
+        }
+
+        void incr_batch(object items,object times,object values){
+            std::vector<LCLitem_t> it=to_vector<LCLitem_t>(items);
+            std::vector<double> ts=to_vector<double>(times);
+            std::vector<LCLweight_t> wt;
+            if (!values.is_none())
+                wt=to_vector<LCLweight_t>(values);
+            if (ts.size()!=it.size() || (!wt.empty() && wt.size()!=it.size())) {
+                PyErr_SetString(PyExc_ValueError,
+                    "items, times and values must have the same length");
+                throw_error_already_set();
+            }
+            for (size_t i=0;i<it.size();++i)
+                WLCL_Update(_wlcl,it[i],ts[i],wt.empty()?1:wt[i]);
+        }
+
+        void advance(double t){
+            WLCL_Advance(_wlcl,t);
+        }
+
+        unsigned capacity(){
+            return WLCL_Size(_wlcl);
+        }
+
+        long long est(LCLitem_t k){
+            return WLCL_PointEst(_wlcl,k);
+        }
+        long long err(LCLitem_t k){
+            return WLCL_PointErr(_wlcl,k);
+        }
+        long long total(){
+            return WLCL_Total(_wlcl);
+        }
+
+        list output(int thresh){
+            list res;
+            std::map<uint32_t, uint32_t> hh=WLCL_Output(_wlcl,thresh);
+
+            for (std::map<uint32_t, uint32_t>::iterator i=hh.begin();
+                 i!=hh.end();++i)
+                res.append(make_tuple(i->first,i->second));
+            return res;
+        }
+};
+
+class HeavyChangers{
+    HC_type* _hc;
+    public:
+        HeavyChangers(float phi,double width):
+            _hc(HC_Init(phi,width))
+        {}
+
+        ~HeavyChangers(){
+          HC_Destroy(_hc);
+        }
+
+        void incr(LCLitem_t item,double t,int value=1){
+            HC_Update(_hc,item,t,value);
+        }
+
+        void incr_batch(object items,object times,object values){
+            std::vector<LCLitem_t> it=to_vector<LCLitem_t>(items);
+            std::vector<double> ts=to_vector<double>(times);
+            std::vector<LCLweight_t> wt;
+            if (!values.is_none())
+                wt=to_vector<LCLweight_t>(values);
+            if (ts.size()!=it.size() || (!wt.empty() && wt.size()!=it.size())) {
+                PyErr_SetString(PyExc_ValueError,
+                    "items, times and values must have the same length");
+                throw_error_already_set();
+            }
+            if (it.empty()) return;
+            HC_UpdateBatch(_hc,&it[0],&ts[0],wt.empty()?NULL:&wt[0],it.size());
+        }
+
+        void advance(double t){
+            HC_Advance(_hc,t);
+        }
+
+        unsigned capacity(){
+            return HC_Size(_hc);
+        }
+
+        tuple changes(long long thresh){
+            // parallel lists (items, before, after, lo, hi), largest
+            // estimated change first
+            list item, before, after, lo, hi;
+            std::vector<HCChange> ch=HC_Changes(_hc,thresh);
+
+            for (size_t i=0;i<ch.size();++i) {
+                item.append(ch[i].item);
+                before.append(ch[i].before);
+                after.append(ch[i].after);
+                lo.append(ch[i].lo);
+                hi.append(ch[i].hi);
+            }
+            return make_tuple(item,before,after,lo,hi);
+        }
+};
+
+class HierarchicalLossyCount{
+    HHH_type* _hhh;
+    public:
+        // prefix lengths such as [8, 16, 24, 32]; sampled, each update
+        // goes to one length only
+        HierarchicalLossyCount(float phi,object bits,bool sampled):
+            _hhh(NULL)
+        {
+            std::vector<int> b=to_vector<int>(bits);
+            if (b.empty() || b.size()>HHH_MAXLEVELS) {
+                PyErr_SetString(PyExc_ValueError,
+                    "bits must list 1 to 33 prefix lengths");
+                throw_error_already_set();
+            }
+            _hhh=HHH_Init(phi,b.size(),&b[0],sampled);
+        }
+
+        ~HierarchicalLossyCount(){
+          HHH_Destroy(_hhh);
+        }
+
+        void incr(LCLitem_t item,int value=1){
+            HHH_Update(_hhh,item,value);
+        }
+
+        void incr_batch(object items,object values){
+            std::vector<LCLitem_t> it=to_vector<LCLitem_t>(items);
+            std::vector<LCLweight_t> wt;
+            if (!values.is_none())
+                wt=to_vector<LCLweight_t>(values);
+            if (!wt.empty() && wt.size()!=it.size()) {
+                PyErr_SetString(PyExc_ValueError,
+                    "items and values must have the same length");
+                throw_error_already_set();
+            }
+            if (it.empty()) return;
+            HHH_UpdateBatch(_hhh,&it[0],wt.empty()?NULL:&wt[0],it.size());
+        }
+
+        unsigned capacity(){
+            return HHH_Size(_hhh);
+        }
+
+        long long est(LCLitem_t prefix,int bits){
+            return HHH_PointEst(_hhh,prefix,bits);
+        }
+        long long err(LCLitem_t prefix,int bits){
+            return HHH_PointErr(_hhh,prefix,bits);
+        }
+        long long total(){
+            return HHH_Total(_hhh);
+        }
+
+        list output(long long thresh){
+            // (prefix, bits, count, conditioned count), longest first
+            list res;
+            std::vector<HHHPrefix> hh=HHH_Output(_hhh,thresh);
+
+            for (size_t i=0;i<hh.size();++i)
+                res.append(make_tuple(hh[i].prefix,hh[i].bits,hh[i].count,
+                                      hh[i].cond));
+            return res;
+        }
+};
+
+class LossyCountQuantiles{
+    LCLQ_type* _lq;
+    public:
+        // keys with phi, values in [0, 2^logu) with epsilon eps; nodes
+        // is the size of the shared pool of q-digest nodes (0: default)
+        LossyCountQuantiles(float phi,double eps,int logu,int nodes):
+            _lq(LCLQ_Init(phi,eps,logu,nodes))
+        {}
+
+        ~LossyCountQuantiles(){
+          LCLQ_Destroy(_lq);
+        }
+
+        void incr(LCLitem_t key,unsigned int value,int weight=1){
+            LCLQ_Update(_lq,key,value,weight);
+        }
+
+        void incr_batch(object keys,object values,object weights){
+            std::vector<LCLitem_t> it=to_vector<LCLitem_t>(keys);
+            std::vector<unsigned int> vs=to_vector<unsigned int>(values);
+            std::vector<LCLweight_t> wt;
+            if (!weights.is_none())
+                wt=to_vector<LCLweight_t>(weights);
+            if (vs.size()!=it.size() || (!wt.empty() && wt.size()!=it.size())) {
+                PyErr_SetString(PyExc_ValueError,
+                    "keys, values and weights must have the same length");
+                throw_error_already_set();
+            }
+            if (it.empty()) return;
+            LCLQ_UpdateBatch(_lq,&it[0],&vs[0],wt.empty()?NULL:&wt[0],
+                             it.size());
+        }
+
+        unsigned capacity(){
+            return LCLQ_Size(_lq);
+        }
+
+        long long est(LCLitem_t k){
+            return LCLQ_PointEst(_lq,k);
+        }
+        long long err(LCLitem_t k){
+            return LCLQ_PointErr(_lq,k);
+        }
+
+        tuple quantiles(LCLitem_t k,object phis){
+            // (weight of the values seen, [quantiles])
+            std::vector<double> ph=to_vector<double>(phis);
+            std::vector<unsigned int> out(ph.size());
+            list res;
+            long long n;
+
+            n=LCLQ_Quantiles(_lq,k,ph.data(),ph.size(),out.data());
+            for (size_t i=0;i<out.size();++i)
+                res.append(out[i]);
+            return make_tuple(n,res);
+        }
+
+        list output(int thresh,object phis){
+            // (key, count, err, weight of the values seen, [quantiles]),
+            // largest count first
+            std::vector<double> ph=to_vector<double>(phis);
+            std::vector<LCLQKey> keys=LCLQ_Output(_lq,thresh,ph.data(),
+                                                  ph.size());
+            list res;
+
+            for (size_t i=0;i<keys.size();++i) {
+                list q;
+                for (size_t j=0;j<keys[i].quantiles.size();++j)
+                    q.append(keys[i].quantiles[j]);
+                res.append(make_tuple(keys[i].item,keys[i].count,keys[i].err,
+                                      keys[i].n,q));
+            }
+            return res;
+        }
+};
+
+class Rollup{
+    RU_type* _ru;
+    public:
+        // kind "lossycount" (param phi) or "qdigest" (param epsilon, over
+        // values in [0, 2^logu)); tiers of width, width*factors[0], ...
+        Rollup(std::string dir,std::string kind,double param,double width,
+               object factors,int logu):
+            _ru(NULL)
+        {
+            std::vector<int> f=to_vector<int>(factors);
+            if (kind=="lossycount")
+                _ru=RU_OpenLCL(dir.c_str(),param,width,f.size()+1,f.data());
+            else if (kind=="qdigest")
+                _ru=RU_OpenQD(dir.c_str(),param,logu,width,f.size()+1,
+                    f.data());
+            else {
+                PyErr_SetString(PyExc_ValueError,
+                    "kind must be 'lossycount' or 'qdigest'");
+                throw_error_already_set();
+            }
+            if (!_ru) {
+                PyErr_SetString(PyExc_IOError,
+                    "cannot open the rollup directory (see stderr)");
+                throw_error_already_set();
+            }
+        }
+
+        ~Rollup(){
+          close();
+        }
+        void close(){
+            RU_Close(_ru);
+            _ru=NULL;
+        }
+        RU_type* open(){
+            if (!_ru) {
+                PyErr_SetString(PyExc_ValueError,"the rollup is closed");
+                throw_error_already_set();
+            }
+            return _ru;
+        }
+
+        void incr(unsigned int item,double t,int value=1){
+            RU_Update(open(),item,t,value);
+        }
+
+        void incr_batch(object items,object times,object values){
+            std::vector<unsigned int> it=to_vector<unsigned int>(items);
+            std::vector<double> ts=to_vector<double>(times);
+            std::vector<int> wt;
+            if (!values.is_none())
+                wt=to_vector<int>(values);
+            if (ts.size()!=it.size() || (!wt.empty() && wt.size()!=it.size())) {
+                PyErr_SetString(PyExc_ValueError,
+                    "items, times and values must have the same length");
+                throw_error_already_set();
+            }
+            RU_type* ru=open();
+            for (size_t i=0;i<it.size();++i)
+                RU_Update(ru,it[i],ts[i],wt.empty()?1:wt[i]);
+        }
+
+        void sync(){
+            RU_Sync(open());
+        }
+        int tiles(double t1,double t2){
+            return RU_Tiles(open(),t1,t2);
+        }
+
+        list output(double t1,double t2,int thresh){
+            // (item, count) over [t1, t2), for a lossycount rollup
+            list res;
+            LCL_type* lcl=RU_QueryLCL(open(),t1,t2);
+            if (!lcl) {
+                PyErr_SetString(PyExc_TypeError,"not a lossycount rollup");
+                throw_error_already_set();
+            }
+            std::map<uint32_t, uint32_t> hh=LCL_Output(lcl,thresh);
+            LCL_Destroy(lcl);
+
+            for (std::map<uint32_t, uint32_t>::iterator i=hh.begin();
+                 i!=hh.end();++i)
+                res.append(make_tuple(i->first,i->second));
+            return res;
+        }
+
+        list quantiles(double t1,double t2,object phis){
+            // quantiles of the values over [t1, t2), for a qdigest rollup
+            std::vector<double> ph=to_vector<double>(phis);
+            std::vector<unsigned int> out(ph.size());
+            list res;
+            QD_type* qd=RU_QueryQD(open(),t1,t2);
+            if (!qd) {
+                PyErr_SetString(PyExc_TypeError,"not a qdigest rollup");
+                throw_error_already_set();
+            }
+            QD_OutputQuantiles(qd,ph.data(),ph.size(),out.data());
+            QD_Destroy(qd);
+            for (size_t i=0;i<out.size();++i)
+                res.append(out[i]);
+            return res;
+        }
+};
+
+class LossyCountPool{
+    LCLP_type* _lclp;
+    public:
+        LossyCountPool(float phi,int groups=1024):
+            _lclp(LCLP_Init(phi,groups))
+        {
+        }
+
+        ~LossyCountPool(){
+          destroy();
+        }
+        void destroy(){
+            LCLP_Destroy(_lclp);
+            _lclp=NULL;
+        }
+
+        void incr(uint64_t group,LCLitem_t item,int value=1){
+            LCLP_Update(_lclp,group,item,value);
+        }
+
+        void incr_batch(object groups,object items,object values){
+            std::vector<uint64_t> gr=to_vector<uint64_t>(groups);
+            std::vector<LCLitem_t> it=to_vector<LCLitem_t>(items);
+            std::vector<LCLweight_t> wt;
+            if (!values.is_none())
+                wt=to_vector<LCLweight_t>(values);
+            if (gr.size()!=it.size() || (!wt.empty() && wt.size()!=it.size())) {
+                PyErr_SetString(PyExc_ValueError,
+                    "groups, items and values must have the same length");
+                throw_error_already_set();
+            }
+            LCLP_UpdateBatch(_lclp,gr.data(),it.data(),
+                wt.empty()?NULL:wt.data(),it.size());
+        }
+
+        size_t capacity(){
+            return LCLP_Size(_lclp);
+        }
+
+        long long groups(){
+            return _lclp->groups;
+        }
+
+        long long total(uint64_t group){
+            return LCLP_Total(_lclp,group);
+        }
+
+        LCLweight_t est(uint64_t group,LCLitem_t k){
+            return LCLP_PointEst(_lclp,group,k);
+        }
+        LCLweight_t err(uint64_t group,LCLitem_t k){
+            return LCLP_PointErr(_lclp,group,k);
+        }
+
+        list output(uint64_t group,int thresh){
+            list res;
+            std::map<uint32_t, uint32_t> hh=LCLP_Output(_lclp,group,thresh);
+
+            for (std::map<uint32_t, uint32_t>::iterator i=hh.begin();
+                 i!=hh.end();++i)
+                res.append(make_tuple(i->first,i->second));
+            return res;
+        }
+
+        dict output_all(int thresh){
+            // {group: [(item, count), ...]} for every group with an item
+            // of count thresh or more
+            dict res;
+            std::vector<LCLPItem> hh=LCLP_OutputAll(_lclp,thresh);
+            list cur;
+            for (size_t i=0;i<hh.size();++i)
+            {
+                if (i==0 || hh[i].group!=hh[i-1].group) {
+                    cur=list();
+                    res[hh[i].group]=cur;
+                }
+                cur.append(make_tuple(hh[i].item,hh[i].count));
+            }
+            return res;
+        }
+};
+
+class PersistentLossyCount{
+    PS_type* _ps;
+    public:
+        PersistentLossyCount(std::string path,float phi):
+            _ps(PS_OpenLCL(path.c_str(),phi))
+        {
+            if (!_ps) {
+                PyErr_SetString(PyExc_IOError,
+                    "cannot open the summary file (see stderr)");
+                throw_error_already_set();
+            }
+        }
+
+        ~PersistentLossyCount(){
+          close();
+        }
+        void close(){
+            // a last checkpoint, then the file is closed
+            PS_Close(_ps);
+            _ps=NULL;
+        }
+        PS_type* open(){
+            if (!_ps) {
+                PyErr_SetString(PyExc_ValueError,"the summary is closed");
+                throw_error_already_set();
+            }
+            return _ps;
+        }
+
+        void incr(LCLitem_t item,int value=1){
+            LCL_Update(PS_LCL(open()),item,value);
+        }
+
+        void incr_batch(object items,object values){
+            std::vector<LCLitem_t> it=to_vector<LCLitem_t>(items);
+            std::vector<LCLweight_t> wt;
+            if (!values.is_none()) {
+                wt=to_vector<LCLweight_t>(values);
+                if (wt.size()!=it.size()) {
+                    PyErr_SetString(PyExc_ValueError,
+                        "items and values must have the same length");
+                    throw_error_already_set();
+                }
+            }
+            LCL_UpdateBatch(PS_LCL(open()),it.data(),
+                wt.empty()?NULL:wt.data(),it.size());
+        }
+
+        bool checkpoint(){
+            return PS_Checkpoint(open());
+        }
+        bool sync(){
+            return PS_Sync(open());
+        }
+        unsigned long long epoch(){
+            return PS_Epoch(open());
+        }
+
+        unsigned capacity(){
+            return LCL_Size(PS_LCL(open()));
+        }
+
+        LCLweight_t est(LCLitem_t k){
+            return LCL_PointEst(PS_LCL(open()),k);
+        }
+        LCLweight_t err(LCLitem_t k){
+            return LCL_PointErr(PS_LCL(open()),k);
+        }
+
+        list output(LCLweight_t thresh){
+            list res;
+            std::map<uint32_t, uint32_t> hh=LCL_Output(PS_LCL(open()),thresh);
+
+            for (std::map<uint32_t, uint32_t>::iterator i=hh.begin();
+                 i!=hh.end();++i)
+                res.append(make_tuple(i->first,i->second));
+            return res;
+        }
+};
+
+class SharedLossyCount{
+    LCL_type* _lcl;
+    LCLS_type* _ls;
+    public:
+        SharedLossyCount(std::string name,float phi):
+            _lcl(LCL_Init(phi))
+        {
+            _ls=LCLS_Create(name.c_str(),_lcl);
+            if (!_ls) {
+                LCL_Destroy(_lcl);
+                PyErr_SetString(PyExc_IOError,
+                    "cannot create the shared memory (see stderr)");
+                throw_error_already_set();
+            }
+        }
+
+        ~SharedLossyCount(){
+          close();
+        }
+        void close(){
+            // readers keep the last snapshot they have mapped
+            if (!_ls) return;
+            LCLS_Close(_ls);
+            LCL_Destroy(_lcl);
+            _ls=NULL;
+            _lcl=NULL;
+        }
+        LCL_type* open(){
+            if (!_ls) {
+                PyErr_SetString(PyExc_ValueError,"the summary is closed");
+                throw_error_already_set();
+            }
+            return _lcl;
+        }
+
+        void incr(LCLitem_t item,int value=1){
+            LCL_Update(open(),item,value);
+        }
+
+        void incr_batch(object items,object values){
+            std::vector<LCLitem_t> it=to_vector<LCLitem_t>(items);
+            std::vector<LCLweight_t> wt;
+            if (!values.is_none()) {
+                wt=to_vector<LCLweight_t>(values);
+                if (wt.size()!=it.size()) {
+                    PyErr_SetString(PyExc_ValueError,
+                        "items and values must have the same length");
+                    throw_error_already_set();
+                }
+            }
+            LCL_UpdateBatch(open(),it.data(),wt.empty()?NULL:wt.data(),
+                it.size());
+        }
+
+        unsigned long long publish(){
+            LCLS_Publish(_ls,open());
+            return LCLS_Version(_ls);
+        }
+        unsigned long long version(){
+            open();
+            return LCLS_Version(_ls);
+        }
+
+        unsigned capacity(){
+            return LCL_Size(open());
+        }
+
+        LCLweight_t est(LCLitem_t k){
+            return LCL_PointEst(open(),k);
+        }
+        LCLweight_t err(LCLitem_t k){
+            return LCL_PointErr(open(),k);
+        }
+
+        list output(LCLweight_t thresh){
+            list res;
+            std::map<uint32_t, uint32_t> hh=LCL_Output(open(),thresh);
+
+            for (std::map<uint32_t, uint32_t>::iterator i=hh.begin();
+                 i!=hh.end();++i)
+                res.append(make_tuple(i->first,i->second));
+            return res;
+        }
+};
+
+class LossyCountReader{
+    LCLS_type* _ls;
+    public:
+        LossyCountReader(std::string name):
+            _ls(LCLS_Attach(name.c_str()))
+        {
+            if (!_ls) {
+                PyErr_SetString(PyExc_IOError,
+                    "cannot attach to the shared memory (see stderr)");
+                throw_error_already_set();
+            }
+        }
+
+        ~LossyCountReader(){
+          close();
+        }
+        void close(){
+            if (!_ls) return;
+            LCLS_Close(_ls);
+            _ls=NULL;
+        }
+        LCLS_type* open(){
+            if (!_ls) {
+                PyErr_SetString(PyExc_ValueError,"the reader is closed");
+                throw_error_already_set();
+            }
+            return _ls;
+        }
+
+        unsigned long long version(){
+            return LCLS_Version(open());
+        }
+
+        LCLweight_t est(LCLitem_t k){
+            return LCLS_PointEst(open(),k);
+        }
+        LCLweight_t err(LCLitem_t k){
+            return LCLS_PointErr(open(),k);
+        }
+
+        list output(LCLweight_t thresh){
+            list res;
+            std::map<uint32_t, uint32_t> hh=LCLS_Output(open(),thresh);
+
+            for (std::map<uint32_t, uint32_t>::iterator i=hh.begin();
+                 i!=hh.end();++i)
+                res.append(make_tuple(i->first,i->second));
+            return res;
+        }
 };
 
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(incr_overloads, incr, 1, 2);
+#ifdef LCL_PAYLOAD
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(payload_overloads, incr_payload, 2, 3);
+#endif
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(f_incr_overloads, incr, 1, 2);
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ccfc_incr_overloads, incr, 1, 2);
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(cgt_incr_overloads, incr, 1, 2);
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(qd_insert_overloads, insert, 1, 2);
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(cm_incr_overloads, incr, 1, 2);
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(lclp_incr_overloads, incr, 2, 3);
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(dlcl_incr_overloads, incr, 2, 3);
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(wlcl_incr_overloads, incr, 2, 3);
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(hc_incr_overloads, incr, 2, 3);
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(hhh_incr_overloads, incr, 1, 2);
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(lclq_incr_overloads, incr, 2, 3);
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ru_incr_overloads, incr, 2, 3);
 
 BOOST_PYTHON_MODULE(lossycount)
 {
     namespace python = boost::python;    
 
-    class_<LossyCount>("LossyCount",init<float>())
+    class_<LossyCount, boost::noncopyable>("LossyCount",init<float>())
+        .def(init<float,int>())
         .def("incr",&LossyCount::incr, incr_overloads())
+        .def("incr_batch",&LossyCount::incr_batch,
+             (arg("items"),arg("values")=object(),arg("aggregate")=false))
         .def("err",&LossyCount::err)
         .def("output",&LossyCount::output)
         .def("est",&LossyCount::est)
+        .def("stats",&LossyCount::stats)
         .def("__del__",&LossyCount::destroy)
-        .def("capacity",&LossyCount::capacity);
+        .def("capacity",&LossyCount::capacity)
+#ifdef LCL_PAYLOAD
+        .def("incr_payload",&LossyCount::incr_payload, payload_overloads())
+        .def("incr_batch_payload",&LossyCount::incr_batch_payload,
+             (arg("items"),arg("xs"),arg("values")=object()))
+        .def("payload",&LossyCount::payload)
+        .def("output_payload",&LossyCount::output_payload)
+#endif
+        ;
+
+    class_<PersistentLossyCount, boost::noncopyable>("PersistentLossyCount",
+        init<std::string,float>())
+        .def("incr",&PersistentLossyCount::incr, incr_overloads())
+        .def("incr_batch",&PersistentLossyCount::incr_batch,
+             (arg("items"),arg("values")=object()))
+        .def("checkpoint",&PersistentLossyCount::checkpoint)
+        .def("sync",&PersistentLossyCount::sync)
+        .def("epoch",&PersistentLossyCount::epoch)
+        .def("err",&PersistentLossyCount::err)
+        .def("output",&PersistentLossyCount::output)
+        .def("est",&PersistentLossyCount::est)
+        .def("close",&PersistentLossyCount::close)
+        .def("capacity",&PersistentLossyCount::capacity);
+
+    class_<SharedLossyCount, boost::noncopyable>("SharedLossyCount",
+        init<std::string,float>())
+        .def("incr",&SharedLossyCount::incr, incr_overloads())
+        .def("incr_batch",&SharedLossyCount::incr_batch,
+             (arg("items"),arg("values")=object()))
+        .def("publish",&SharedLossyCount::publish)
+        .def("version",&SharedLossyCount::version)
+        .def("err",&SharedLossyCount::err)
+        .def("output",&SharedLossyCount::output)
+        .def("est",&SharedLossyCount::est)
+        .def("close",&SharedLossyCount::close)
+        .def("capacity",&SharedLossyCount::capacity);
+
+    class_<LossyCountReader, boost::noncopyable>("LossyCountReader",
+        init<std::string>())
+        .def("version",&LossyCountReader::version)
+        .def("err",&LossyCountReader::err)
+        .def("output",&LossyCountReader::output)
+        .def("est",&LossyCountReader::est)
+        .def("close",&LossyCountReader::close);
+
+    class_<DecayedLossyCount, boost::noncopyable>("DecayedLossyCount",
+        init<float,double>())
+        .def(init<float,double,int>())
+        .def("incr",&DecayedLossyCount::incr, dlcl_incr_overloads())
+        .def("incr_batch",&DecayedLossyCount::incr_batch,
+             (arg("items"),arg("times"),arg("values")=object()))
+        .def("err",&DecayedLossyCount::err)
+        .def("output",&DecayedLossyCount::output)
+        .def("est",&DecayedLossyCount::est)
+        .def("total",&DecayedLossyCount::total)
+        .def("capacity",&DecayedLossyCount::capacity);
+
+    class_<WindowLossyCount, boost::noncopyable>("WindowLossyCount",
+        init<float,int,double>())
+        .def("incr",&WindowLossyCount::incr, wlcl_incr_overloads())
+        .def("incr_batch",&WindowLossyCount::incr_batch,
+             (arg("items"),arg("times"),arg("values")=object()))
+        .def("advance",&WindowLossyCount::advance)
+        .def("err",&WindowLossyCount::err)
+        .def("output",&WindowLossyCount::output)
+        .def("est",&WindowLossyCount::est)
+        .def("total",&WindowLossyCount::total)
+        .def("capacity",&WindowLossyCount::capacity);
+
+    class_<HeavyChangers, boost::noncopyable>("HeavyChangers",
+        init<float,double>())
+        .def("incr",&HeavyChangers::incr, hc_incr_overloads())
+        .def("incr_batch",&HeavyChangers::incr_batch,
+             (arg("items"),arg("times"),arg("values")=object()))
+        .def("advance",&HeavyChangers::advance)
+        .def("changes",&HeavyChangers::changes)
+        .def("capacity",&HeavyChangers::capacity);
+
+    class_<HierarchicalLossyCount, boost::noncopyable>(
+        "HierarchicalLossyCount",init<float,object,bool>(
+            (arg("phi"),arg("bits"),arg("sampled")=true)))
+        .def("incr",&HierarchicalLossyCount::incr, hhh_incr_overloads())
+        .def("incr_batch",&HierarchicalLossyCount::incr_batch,
+             (arg("items"),arg("values")=object()))
+        .def("err",&HierarchicalLossyCount::err)
+        .def("output",&HierarchicalLossyCount::output)
+        .def("est",&HierarchicalLossyCount::est)
+        .def("total",&HierarchicalLossyCount::total)
+        .def("capacity",&HierarchicalLossyCount::capacity);
+
+    class_<LossyCountQuantiles, boost::noncopyable>("LossyCountQuantiles",
+        init<float,double,int,int>(
+            (arg("phi"),arg("eps"),arg("logu"),arg("nodes")=0)))
+        .def("incr",&LossyCountQuantiles::incr, lclq_incr_overloads())
+        .def("incr_batch",&LossyCountQuantiles::incr_batch,
+             (arg("keys"),arg("values"),arg("weights")=object()))
+        .def("err",&LossyCountQuantiles::err)
+        .def("output",&LossyCountQuantiles::output)
+        .def("est",&LossyCountQuantiles::est)
+        .def("quantiles",&LossyCountQuantiles::quantiles)
+        .def("capacity",&LossyCountQuantiles::capacity);
+
+    class_<Rollup, boost::noncopyable>("Rollup",
+        init<std::string,std::string,double,double,object,int>(
+            (arg("dir"),arg("kind"),arg("param"),arg("width"),
+             arg("factors"),arg("logu")=32)))
+        .def("incr",&Rollup::incr, ru_incr_overloads())
+        .def("incr_batch",&Rollup::incr_batch,
+             (arg("items"),arg("times"),arg("values")=object()))
+        .def("sync",&Rollup::sync)
+        .def("tiles",&Rollup::tiles)
+        .def("output",&Rollup::output)
+        .def("quantiles",&Rollup::quantiles)
+        .def("close",&Rollup::close);
+
+    class_<LossyCountPool, boost::noncopyable>("LossyCountPool",
+        init<float,optional<int> >())
+        .def("incr",&LossyCountPool::incr, lclp_incr_overloads())
+        .def("incr_batch",&LossyCountPool::incr_batch,
+             (arg("groups"),arg("items"),arg("values")=object()))
+        .def("err",&LossyCountPool::err)
+        .def("output",&LossyCountPool::output)
+        .def("output_all",&LossyCountPool::output_all)
+        .def("est",&LossyCountPool::est)
+        .def("total",&LossyCountPool::total)
+        .def("groups",&LossyCountPool::groups)
+        .def("__del__",&LossyCountPool::destroy)
+        .def("capacity",&LossyCountPool::capacity);
+
+    class_<Frequent, boost::noncopyable>("Frequent",init<float>())
+        .def("incr",&Frequent::incr, f_incr_overloads())
+        .def("err",&Frequent::err)
+        .def("output",&Frequent::output)
+        .def("est",&Frequent::est)
+        .def("__del__",&Frequent::destroy)
+        .def("capacity",&Frequent::capacity);
+
+    class_<CountMin, boost::noncopyable>("CountMin",
+            init<int,int,optional<int,bool> >())
+        .def("incr",&CountMin::incr, cm_incr_overloads())
+        .def("incr_batch",&CountMin::incr_batch,
+            (arg("items"),arg("values")=object()))
+        .def("est",&CountMin::est)
+        .def("est_batch",&CountMin::est_batch)
+        .def("merge",&CountMin::merge)
+        .def("total",&CountMin::total)
+        .def("__del__",&CountMin::destroy)
+        .def("capacity",&CountMin::capacity);
+
+    class_<QDigest, boost::noncopyable>("QDigest",init<double,int>())
+        .def("insert",&QDigest::insert, qd_insert_overloads())
+        .def("insert_batch",&QDigest::insert_batch)
+        .def("quantile",&QDigest::quantile)
+        .def("quantiles",&QDigest::quantiles)
+        .def("stats",&QDigest::stats)
+        .def("__del__",&QDigest::destroy)
+        .def("capacity",&QDigest::capacity);
+
+    class_<GK, boost::noncopyable>("GK",init<double>())
+        .def("insert",&GK::insert)
+        .def("insert_batch",&GK::insert_batch)
+        .def("quantile",&GK::quantile)
+        .def("quantiles",&GK::quantiles)
+        .def("__del__",&GK::destroy)
+        .def("capacity",&GK::capacity);
+
+    class_<GroupTest, boost::noncopyable>("GroupTest",
+            init<int,int,optional<int,int> >())
+        .def("incr",&GroupTest::incr, cgt_incr_overloads())
+        .def("incr_batch",&GroupTest::incr_batch,
+            (arg("items"),arg("values")=object()))
+        .def("est",&GroupTest::est)
+        .def("output",&GroupTest::output)
+        .def("merge",&GroupTest::merge)
+        .def("total",&GroupTest::total)
+        .def("__del__",&GroupTest::destroy)
+        .def("capacity",&GroupTest::capacity);
+
+    class_<CountSketch, boost::noncopyable>("CountSketch",
+            init<int,int,optional<int> >())
+        .def("incr",&CountSketch::incr, ccfc_incr_overloads())
+        .def("incr_batch",&CountSketch::incr_batch,
+            (arg("items"),arg("values")=object()))
+        .def("est",&CountSketch::est)
+        .def("inner",&CountSketch::inner)
+        .def("merge",&CountSketch::merge)
+        .def("total",&CountSketch::total)
+        .def("__del__",&CountSketch::destroy)
+        .def("capacity",&CountSketch::capacity);
 
 
 }
@@ -25,3 +25,177 @@ result.sort(key=lambda x: -x[1])
 print(result)
 
 print(lc.capacity())
+
+# PersistentLossyCount 在进程被杀掉之后重新打开
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+from lossycount import PersistentLossyCount
+
+
+def killed(code):
+  # 在另一个进程里运行 code, 然后不做清理直接退出 (像被杀掉一样)
+  subprocess.check_call([sys.executable, "-c",
+    "import os\nfrom lossycount import *\n" + code + "\nos._exit(0)"])
+
+
+tmp = tempfile.mkdtemp()
+path = os.path.join(tmp, "top.lc")
+
+# 第一次 checkpoint 之前被杀掉: 文件仍然可以打开, 是空的
+killed("s = PersistentLossyCount(%r, 0.01)\ns.incr(7, 5)" % path)
+s = PersistentLossyCount(path, 0.01)
+assert s.est(7) == 0 and s.epoch() == 0
+
+# checkpoint 之后被杀掉: 得到 checkpoint 时的内容
+s.close()  # 第 1 个 checkpoint
+killed("s = PersistentLossyCount(%r, 0.01)\ns.incr(7, 5)\n"
+  "s.checkpoint()\ns.sync()\ns.incr(7, 100)" % path)
+s = PersistentLossyCount(path, 0.01)
+assert s.est(7) == 5 and s.epoch() == 2
+
+# 最新的 checkpoint 被写坏: 退回到前一个
+s.incr(7, 10)
+s.checkpoint()
+s.sync()
+assert s.epoch() == 3
+s.incr(7, 1)
+s.close()  # 第 4 个 checkpoint (16), 写在 slot 0
+with open(path, "r+b") as f:
+  f.seek(4096)
+  f.write(b"\xff" * 64)
+s = PersistentLossyCount(path, 0.01)
+assert s.est(7) == 15 and s.epoch() == 3
+s.close()
+s.close()
+try:
+  s.est(7)
+  assert False
+except ValueError:
+  pass
+shutil.rmtree(tmp)
+print("PersistentLossyCount ok")
+
+# LossyCountReader 读到的每个快照都是完整的一次 publish
+from lossycount import SharedLossyCount, LossyCountReader
+
+name = "/lossycount-test-%d" % os.getpid()
+w = SharedLossyCount(name, 0.01)
+w.incr(1, 3)
+w.incr(2, 3)
+v = w.publish()
+r = LossyCountReader(name)
+w.incr(1, 5)  # 还没有 publish, 读者看不到
+assert r.version() == v and r.est(1) == 3
+w.incr(2, 5)
+assert w.publish() == v + 1
+assert r.version() == v + 1 and r.est(1) == 8 and r.est(2) == 8
+w.close()
+
+# 另一个进程一边更新一边 publish, 每个快照里 1 和 2 的次数都相同
+name = name + "-busy"
+writer = subprocess.Popen([sys.executable, "-c",
+  "import sys\nfrom lossycount import SharedLossyCount\n"
+  "w = SharedLossyCount(%r, 0.01)\n"
+  "print(w.version())\nsys.stdout.flush()\n"
+  "for i in range(20000):\n"
+  "  w.incr_batch([1, 2] * 50 + list(range(100, 150)), None)\n"
+  "  w.publish()\n"
+  "sys.stdin.read()\n" % name],
+  stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+v = int(writer.stdout.readline())
+r = LossyCountReader(name)
+seen = 0
+while r.version() < v + 20000:
+  hh = dict(r.output(1))
+  assert hh.get(1, 0) == hh.get(2, 0)
+  seen += 1
+hh = dict(r.output(1))
+assert hh[1] == hh[2] == 20000 * 50
+writer.communicate()
+r.close()
+r.close()
+try:
+  r.est(1)
+  assert False
+except ValueError:
+  pass
+print("LossyCountReader ok (%d snapshots)" % seen)
+
+# Rollup: 一段时间的查询等于它的各个分钟合并, 重启之后接着写打开的分钟
+from lossycount import Rollup
+
+tmp = tempfile.mkdtemp()
+ru = Rollup(tmp, "lossycount", 0.01, 60, [60])
+exact = {}
+for m in range(150):
+  for item, wt in ((m % 5, m % 3 + 1), (100, 1)):
+    ru.incr(item, m * 60 + 1, wt)
+    if m < 120:
+      exact[item] = exact.get(item, 0) + wt
+ru.sync()
+assert ru.tiles(0, 7200) == 2  # 两个小时
+merged = {}
+for m in range(120):
+  for item, c in ru.output(m * 60, (m + 1) * 60, 1):
+    merged[item] = merged.get(item, 0) + c
+assert dict(ru.output(0, 7200, 1)) == merged == exact
+ru.incr(7, 149 * 60 + 10)
+before = dict(ru.output(0, 150 * 60, 1))
+ru.close()
+ru = Rollup(tmp, "lossycount", 0.01, 60, [60])
+assert dict(ru.output(0, 150 * 60, 1)) == before
+ru.incr(7, 149 * 60 + 20)
+assert dict(ru.output(149 * 60, 150 * 60, 1))[7] == 2
+ru.close()
+ru.close()
+try:
+  ru.tiles(0, 60)
+  assert False
+except ValueError:
+  pass
+try:
+  Rollup(tmp, "lossycount", 0.02, 60, [60])  # 形状不同
+  assert False
+except IOError:
+  pass
+shutil.rmtree(tmp)
+print("Rollup ok")
+
+# Frequent.output 按上界筛选, 不会漏掉真正的高频项
+import random
+from lossycount import Frequent
+
+rnd = random.Random(1)
+f = Frequent(0.01)
+exact = {}
+for i in range(200000):
+  x = int(rnd.paretovariate(0.8))
+  f.incr(x)
+  exact[x] = exact.get(x, 0) + 1
+hh = dict(f.output(2000))
+for x, c in exact.items():
+  if c >= 2000:
+    assert x in hh and f.est(x) <= c <= hh[x] == f.est(x) + f.err(x)
+print("Frequent ok")
+
+# LossyCount.incr_batch 和逐个 incr 的结果完全相同
+rnd = random.Random(2)
+items = [int(rnd.paretovariate(0.5)) % 1000003 for i in range(200000)]
+weights = [rnd.randint(1, 5) for i in items]
+for values in (None, weights):
+  one = LossyCount(0.001, 7)
+  batch = LossyCount(0.001, 7)
+  for i, x in enumerate(items):
+    one.incr(x, values[i] if values else 1)
+  i = 0
+  while i < len(items):  # 长短不一的批次, 跨过内部的分块
+    m = rnd.randint(1, 3000)
+    batch.incr_batch(items[i:i + m], values[i:i + m] if values else None)
+    i += m
+  assert sorted(one.output(1)) == sorted(batch.output(1))
+  for x in set(items):
+    assert one.est(x) == batch.est(x) and one.err(x) == batch.err(x)
+print("LossyCount.incr_batch ok")